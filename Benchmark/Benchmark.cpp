@@ -0,0 +1,468 @@
+#include <cstdio>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "Plumber.h"
+#include "GraphCulling.h"
+#include "Renderpass.h"
+#include "DeferredRenderingPass.h"
+#include "RHI.h"
+#include "LinearAlloc.h"
+#include "DownSamplePass.h"
+#include "PostprocessingPass.h"
+#include "TaskScheduler.h"
+#include "QueueAssignment.h"
+#include "MemoryEstimator.h"
+
+/* Benchmark for building, culling and scheduling graphs */
+/* usage: rdag_bench [--iterations N] [--filter Substring] [--output File] [--schedule recorded|memory|distance] [--cache 1] [--lazy 1] [--check-lazy 1] [--threads N] [--min-parallel-tasks N] [--async 1] */
+/* with --cache the builder records graph keys and one GraphProcessor is kept, graphs that match an earlier graph entry by entry skip culling and scheduling */
+/* with --async actions that only write UAVs go to the async compute queue and the simulated queue overlap of the last iteration is reported */
+/* with --lazy renderpasses are only built when a consumer of the graph output needs them, LazyBuilding/UnusedDebugPyramid has a pass nothing reads */
+/* with --check-lazy every scenario is built eagerly and lazily, it fails when lazy building is slower on the cascade sweep */
+/* with --threads the builder records independent branches and the GraphProcessor runs plans of at least --min-parallel-tasks actions as tasks on a TaskScheduler with N workers */
+/* on a single core both stay serial, the tasks were slower there at every graph size */
+/* the transient memory peaks are estimated on the schedule of the last iteration, so --schedule memory shows its effect there */
+/* a summary is printed to stderr and one json object per scenario is written to the output file */
+
+namespace RDAG
+{
+	SIMPLE_TEX_HANDLE(SimpleResourceHandle);
+	SIMPLE_UAV_HANDLE(DebugSceneColor, DebugSceneColor);
+	SIMPLE_UAV_HANDLE(BranchAScratch, BranchAScratch);
+	SIMPLE_TEX_HANDLE(BranchAScratchInput);
+	SIMPLE_UAV_HANDLE(BranchBScratch, BranchBScratch);
+	SIMPLE_TEX_HANDLE(BranchBScratchInput);
+	SIMPLE_UAV_HANDLE(BranchAResult, BranchAResult);
+	SIMPLE_TEX_HANDLE(BranchAResultInput);
+	SIMPLE_UAV_HANDLE(BranchBResult, BranchBResult);
+	SIMPLE_TEX_HANDLE(BranchBResultInput);
+	EXTERNAL_UAV_HANDLE(BranchCombineOutput, BranchCombineOutput);
+}
+
+using BuildFunctionType = std::function<void(const RenderPassBuilder&)>;
+
+struct Scenario
+{
+	std::string Name;
+	BuildFunctionType Build;
+};
+
+struct PhaseTimings
+{
+	std::vector<double> Samples;
+
+	double Percentile(double P) const
+	{
+		std::vector<double> Sorted = Samples;
+		std::sort(Sorted.begin(), Sorted.end());
+		size_t Index = size_t(P * double(Sorted.size() - 1) + 0.5);
+		return Sorted[Index];
+	}
+};
+
+struct ScenarioResult
+{
+	std::string Name;
+	size_t NumActions = 0;
+	PhaseTimings Build;
+	PhaseTimings Cull;
+	PhaseTimings Schedule;
+	U64 SerialQueueTime = 0;
+	U64 ParallelQueueTime = 0;
+	U32 NumFences = 0;
+	U64 LivePeakBytes = 0;
+	U64 AliasedPeakBytes = 0;
+};
+
+static double ElapsedMicroseconds(std::chrono::high_resolution_clock::time_point Start, std::chrono::high_resolution_clock::time_point End)
+{
+	return std::chrono::duration<double, std::micro>(End - Start).count();
+}
+
+/* a lazy builder only builds the renderpasses that the outputs of the graph need */
+template<typename... Handles, typename TableType>
+static void ResolveGraphOutputs(const RenderPassBuilder& Builder, const TableType& Outputs)
+{
+	if (Builder.IsLazyPassBuilding())
+	{
+		Builder.ResolveLazyPasses<Handles...>()(Outputs);
+	}
+}
+
+static void SimpleRenderPassScenario(const RenderPassBuilder& Builder)
+{
+	using PassInputType = ResourceTable<>;
+	using PassOutputType = ResourceTable<RDAG::SimpleResourceHandle>;
+	auto SimpleRenderPass = [](const RenderPassBuilder& Builder, const PassInputType& Input) -> PassOutputType
+	{
+		Texture2d::Descriptor TargetDescriptor;
+		TargetDescriptor.Name = "RenderTarget";
+		TargetDescriptor.Format = ERenderResourceFormat::ARGB8U;
+		TargetDescriptor.Height = 32;
+		TargetDescriptor.Width = 32;
+		TargetDescriptor.ComputeFullMipChain();
+
+		return Seq
+		{
+			Builder.CreateResource<RDAG::SimpleResourceHandle>( TargetDescriptor ),
+			Builder.QueueRenderAction("SimpleRenderAction", [](RenderContext& Ctx, const PassOutputType&)
+			{
+				Ctx.Draw("SimpleRenderAction");
+			})
+		}(Input);
+	};
+
+	auto Result = Seq
+	{
+		Builder.BuildRenderPass("SimpleRenderPass", SimpleRenderPass),
+		Builder.AssignEntry<RDAG::SimpleResourceHandle, RDAG::DownsampleInput>(),
+		Builder.BuildRenderPass("PyramidDownSampleRenderPass", PyramidDownSampleRenderPass::Build),
+		Builder.AssignEntry<RDAG::DownsamplePyramid, RDAG::PostProcessingInput>(2),
+		Builder.BuildRenderPass("ToneMappingPass", ToneMappingPass::Build)
+	}(ResourceTable<>());
+	ResolveGraphOutputs<RDAG::PostProcessingResult>(Builder, Result);
+}
+
+/* a debug pyramid of the scene color is built but nothing reads it, eager building records its actions and culling removes them */
+static void UnusedDebugPyramidScenario(const RenderPassBuilder& Builder)
+{
+	Texture2d::Descriptor SceneColorDescriptor;
+	SceneColorDescriptor.Name = "DebugSceneColor";
+	SceneColorDescriptor.Format = ERenderResourceFormat::ARGB16F;
+	SceneColorDescriptor.Height = 1080;
+	SceneColorDescriptor.Width = 1920;
+
+	using SceneColorAction = ResourceTable<RDAG::DebugSceneColor>;
+	auto Result = Seq
+	{
+		Builder.CreateResource<RDAG::DebugSceneColor>(SceneColorDescriptor),
+		Builder.QueueRenderAction("DebugSceneColorAction", [](RenderContext& Ctx, const SceneColorAction&)
+		{
+			Ctx.Draw("DebugSceneColorAction");
+		}),
+		Builder.AssignEntry<RDAG::DebugSceneColor, RDAG::DownsampleInput>(),
+		Builder.BuildRenderPass("DebugPyramidDownSampleRenderPass", PyramidDownSampleRenderPass::Build),
+		Builder.AssignEntry<RDAG::DebugSceneColor, RDAG::PostProcessingInput>(),
+		Builder.BuildRenderPass("ToneMappingPass", ToneMappingPass::Build)
+	}(ResourceTable<>());
+	ResolveGraphOutputs<RDAG::PostProcessingResult>(Builder, Result);
+}
+
+/* two independent branches that each write a big scratch texture and reduce it to a small result, recorded interleaved */
+/* in recorded order both scratch textures are alive at the same time, MinimizeMemory reduces the first branch before the second scratch is written */
+static void MemoryPressureScenario(const RenderPassBuilder& Builder)
+{
+	Texture2d::Descriptor ScratchDescriptor;
+	ScratchDescriptor.Name = "BranchScratch";
+	ScratchDescriptor.Format = ERenderResourceFormat::ARGB16F;
+	ScratchDescriptor.Width = 3840;
+	ScratchDescriptor.Height = 2160;
+
+	Texture2d::Descriptor ResultDescriptor;
+	ResultDescriptor.Name = "BranchResult";
+	ResultDescriptor.Format = ERenderResourceFormat::ARGB16F;
+	ResultDescriptor.Width = 64;
+	ResultDescriptor.Height = 64;
+
+	Texture2d::Descriptor OutputDescriptor = ResultDescriptor;
+	OutputDescriptor.Name = "BranchCombineOutput";
+
+	using WriteScratchA = ResourceTable<RDAG::BranchAScratch>;
+	using WriteScratchB = ResourceTable<RDAG::BranchBScratch>;
+	using ReduceA = ResourceTable<RDAG::BranchAScratchInput, RDAG::BranchAResult>;
+	using ReduceB = ResourceTable<RDAG::BranchBScratchInput, RDAG::BranchBResult>;
+	using Combine = ResourceTable<RDAG::BranchAResultInput, RDAG::BranchBResultInput, RDAG::BranchCombineOutput>;
+
+	auto Result = Seq
+	{
+		Builder.CreateResource<RDAG::BranchAScratch>(ScratchDescriptor),
+		Builder.QueueRenderAction("WriteScratchA", [](RenderContext& Ctx, const WriteScratchA&)
+		{
+			Ctx.Draw("WriteScratchA");
+		}),
+		Builder.CreateResource<RDAG::BranchBScratch>(ScratchDescriptor),
+		Builder.QueueRenderAction("WriteScratchB", [](RenderContext& Ctx, const WriteScratchB&)
+		{
+			Ctx.Draw("WriteScratchB");
+		}),
+		Builder.AssignEntry<RDAG::BranchAScratch, RDAG::BranchAScratchInput>(),
+		Builder.CreateResource<RDAG::BranchAResult>(ResultDescriptor),
+		Builder.QueueRenderAction("ReduceA", [](RenderContext& Ctx, const ReduceA&)
+		{
+			Ctx.Draw("ReduceA");
+		}),
+		Builder.AssignEntry<RDAG::BranchBScratch, RDAG::BranchBScratchInput>(),
+		Builder.CreateResource<RDAG::BranchBResult>(ResultDescriptor),
+		Builder.QueueRenderAction("ReduceB", [](RenderContext& Ctx, const ReduceB&)
+		{
+			Ctx.Draw("ReduceB");
+		}),
+		Builder.AssignEntry<RDAG::BranchAResult, RDAG::BranchAResultInput>(),
+		Builder.AssignEntry<RDAG::BranchBResult, RDAG::BranchBResultInput>(),
+		Builder.CreateResource<RDAG::BranchCombineOutput>(OutputDescriptor),
+		Builder.QueueRenderAction("Combine", [](RenderContext& Ctx, const Combine&)
+		{
+			Ctx.Draw("Combine");
+		})
+	}(ResourceTable<>());
+	(void)Result;
+}
+
+static BuildFunctionType DeferredRendererScenario(const SceneViewInfo& ViewInfo)
+{
+	return [ViewInfo](const RenderPassBuilder& Builder)
+	{
+		auto Result = Builder.BuildRenderPass("MainRenderPass", DeferredRendererPass::Build, ViewInfo)(ResourceTable<>());
+		ResolveGraphOutputs<RDAG::PostProcessingResult>(Builder, Result);
+	};
+}
+
+static std::vector<Scenario> CreateScenarios()
+{
+	SceneViewInfo DefaultViewInfo;
+	DefaultViewInfo.MainTemporalAAKey = InternedStrings::Intern("MainTemporalAA");
+	DefaultViewInfo.DoFTemporalAAKey = InternedStrings::Intern("DofTemporalAA");
+
+	std::vector<Scenario> Scenarios;
+	Scenarios.push_back({ "SimpleRenderPass", SimpleRenderPassScenario });
+	Scenarios.push_back({ "LazyBuilding/UnusedDebugPyramid", UnusedDebugPyramidScenario });
+	Scenarios.push_back({ "DeferredRendererPass", DeferredRendererScenario(DefaultViewInfo) });
+
+	/* every toggle of the SceneViewInfo flipped on its own */
+	auto AddToggle = [&](const char* Name, const std::function<void(SceneViewInfo&)>& Toggle)
+	{
+		SceneViewInfo ViewInfo = DefaultViewInfo;
+		Toggle(ViewInfo);
+		Scenarios.push_back({ std::string("DeferredRendererPass/") + Name, DeferredRendererScenario(ViewInfo) });
+	};
+
+	AddToggle("DistanceFieldAO", [](SceneViewInfo& V) { V.AmbientOcclusionType = EAmbientOcclusionType::DistanceField; });
+	AddToggle("NoTransparency", [](SceneViewInfo& V) { V.TransparencyEnabled = false; });
+	AddToggle("NoSeperateTransparency", [](SceneViewInfo& V) { V.TransparencySeperateEnabled = false; });
+	AddToggle("NoTemporalAA", [](SceneViewInfo& V) { V.TemporalAaEnabled = false; });
+	AddToggle("NoDepthOfField", [](SceneViewInfo& V) { V.DepthOfFieldEnabled = false; });
+	AddToggle("NoDofForegroundLayer", [](SceneViewInfo& V) { V.DofSettings.EnabledForegroundLayer = false; });
+	AddToggle("NoDofBackgroundLayer", [](SceneViewInfo& V) { V.DofSettings.EnabledBackgroundLayer = false; });
+	AddToggle("DofCircleBokeh", [](SceneViewInfo& V) { V.DofSettings.BokehShapeIsCircle = true; });
+	AddToggle("NoDofGatherForeground", [](SceneViewInfo& V) { V.DofSettings.GatherForeground = false; });
+	AddToggle("NoDofPostfilter", [](SceneViewInfo& V) { V.DofSettings.EnablePostfilterMethod = false; });
+	AddToggle("DofRecombineQuality0", [](SceneViewInfo& V) { V.DofSettings.RecombineQuality = 0; });
+
+	/* a setting that changes every frame, the rest of the graph stays the same */
+	{
+		SceneViewInfo ViewInfo = DefaultViewInfo;
+		ViewInfo.DofSettings.RecombineQuality = 0;
+		BuildFunctionType Even = DeferredRendererScenario(DefaultViewInfo);
+		BuildFunctionType Odd = DeferredRendererScenario(ViewInfo);
+		U32 Frame = 0;
+		Scenarios.push_back({ "DeferredRendererPass/AlternatingRecombineQuality", [Even, Odd, Frame](const RenderPassBuilder& Builder) mutable
+		{
+			(Frame++ & 1 ? Odd : Even)(Builder);
+		}});
+	}
+
+	for (U32 Cascades : { 1u, 2u, 4u, 8u, 16u, 64u, 256u, 1024u })
+	{
+		SceneViewInfo ViewInfo = DefaultViewInfo;
+		ViewInfo.ShadowCascades = Cascades;
+		Scenarios.push_back({ "DeferredRendererPass/Cascades" + std::to_string(Cascades), DeferredRendererScenario(ViewInfo) });
+	}
+
+	const U32 Resolutions[][2] = { { 1280, 720 }, { 1920, 1080 }, { 2560, 1440 }, { 3840, 2160 } };
+	for (const U32 (&Resolution)[2] : Resolutions)
+	{
+		SceneViewInfo ViewInfo = DefaultViewInfo;
+		ViewInfo.SceneWidth = Resolution[0];
+		ViewInfo.SceneHeight = Resolution[1];
+		Scenarios.push_back({ "DeferredRendererPass/Resolution" + std::to_string(Resolution[0]) + "x" + std::to_string(Resolution[1]), DeferredRendererScenario(ViewInfo) });
+	}
+
+	Scenarios.push_back({ "MemoryPressure/TwoBranches", MemoryPressureScenario });
+	return Scenarios;
+}
+
+static ScenarioResult RunScenario(const Scenario& InScenario, int IterationCount, bool Cache, bool Lazy, bool Async, TaskScheduler* Scheduler, U32 MinParallelTasks, EGraphSchedulePolicy SchedulePolicy)
+{
+	ScenarioResult Result;
+	Result.Name = InScenario.Name;
+
+	RenderPassBuilder Builder;
+	Builder.SetLazyPassBuilding(Lazy);
+	Builder.SetTaskScheduler(Scheduler);
+	Builder.SetGraphKeyRecording(Cache);
+	//like a renderer the processor is kept over the frames, so its buffers only grow during the first iterations
+	GraphProcessor GPU;
+	for (int i = 0; i < IterationCount; i++)
+	{
+		LinearReset();
+		Builder.Reset();
+
+		auto BuildStart = std::chrono::high_resolution_clock::now();
+		InScenario.Build(Builder);
+		auto BuildEnd = std::chrono::high_resolution_clock::now();
+
+		GPU.SetSchedulePolicy(SchedulePolicy);
+		GPU.SetTaskScheduler(Scheduler);
+		GPU.SetMinParallelTasks(MinParallelTasks);
+		GPU.SetAsyncCompute(Async);
+		if (Cache)
+			GPU.ColorGraphNodes(Builder);
+		else
+			GPU.ColorGraphNodes(Builder.GetActionList());
+		auto CullEnd = std::chrono::high_resolution_clock::now();
+
+		ImmediateRenderContext RndCtx;
+		if (Cache)
+			GPU.ScheduleGraphNodes(RndCtx, Builder);
+		else
+			GPU.ScheduleGraphNodes(RndCtx, Builder.GetActionList());
+		auto ScheduleEnd = std::chrono::high_resolution_clock::now();
+
+		if (Async && i + 1 == IterationCount)
+		{
+			MultiQueueSimulator Simulator;
+			Simulator.Simulate(GPU.GetQueueAssignment());
+			Result.SerialQueueTime = Simulator.GetSerialTime();
+			Result.ParallelQueueTime = Simulator.GetParallelTime();
+			Result.NumFences = U32(GPU.GetQueueAssignment().GetFences().size());
+		}
+
+		if (i + 1 == IterationCount)
+		{
+			TransientMemoryEstimator Estimator;
+			Estimator.Estimate(GPU.GetSchedule());
+			Result.LivePeakBytes = Estimator.GetPeakBytes();
+			Result.AliasedPeakBytes = Estimator.GetAliasedBytes();
+		}
+
+		TransientResourcePool<Texture2d>::Get().NextFrame();
+		ExternalResourceRegistry<Texture2d>::Get().NextFrame();
+
+		Result.Build.Samples.push_back(ElapsedMicroseconds(BuildStart, BuildEnd));
+		Result.Cull.Samples.push_back(ElapsedMicroseconds(BuildEnd, CullEnd));
+		Result.Schedule.Samples.push_back(ElapsedMicroseconds(CullEnd, ScheduleEnd));
+		Result.NumActions = Builder.GetActionList().size();
+	}
+	return Result;
+}
+
+static void WritePhase(FILE* File, const char* Name, const PhaseTimings& Timings)
+{
+	fprintf(File, R"("%s": { "min": %.3f, "median": %.3f, "p99": %.3f })", Name, Timings.Percentile(0.0), Timings.Percentile(0.5), Timings.Percentile(0.99));
+}
+
+/* builds every scenario eagerly and lazily, on the cascade sweep lazy building has to record the same actions and must not be slower */
+/* the tolerance keeps the check from failing on timer noise */
+static int CheckLazyBuilding(const char* Filter, int IterationCount)
+{
+	const double Tolerance = 1.1;
+	U32 NumFailed = 0;
+	fprintf(stderr, "%-48s %10s %10s %8s\n", "scenario (us)", "eager", "lazy", "ratio");
+	for (const Scenario& S : CreateScenarios())
+	{
+		if (S.Name.find(Filter) == std::string::npos)
+			continue;
+
+		ScenarioResult Eager = RunScenario(S, IterationCount, false, false, false, nullptr, 0, EGraphSchedulePolicy::RecordedOrder);
+		ScenarioResult Lazy = RunScenario(S, IterationCount, false, true, false, nullptr, 0, EGraphSchedulePolicy::RecordedOrder);
+		const double Ratio = Lazy.Build.Percentile(0.5) / Eager.Build.Percentile(0.5);
+		const bool IsCascadeSweep = S.Name.find("/Cascades") != std::string::npos;
+		const bool Failed = IsCascadeSweep && (Ratio > Tolerance || Lazy.NumActions != Eager.NumActions);
+		NumFailed += Failed ? 1 : 0;
+
+		fprintf(stderr, "%-48s %10.2f %10.2f %8.2f%s\n", S.Name.c_str(), Eager.Build.Percentile(0.5), Lazy.Build.Percentile(0.5), Ratio, Failed ? " lazy is slower" : "");
+	}
+	return NumFailed == 0 ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+	int IterationCount = 1000;
+	const char* Filter = "";
+	const char* OutputFile = "bench_output.json";
+	bool Cache = false;
+	bool Lazy = false;
+	int NumThreads = 0;
+	int MinParallelTasks = 128;
+	bool Async = false;
+	bool CheckLazy = false;
+	EGraphSchedulePolicy SchedulePolicy = EGraphSchedulePolicy::RecordedOrder;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		std::string Arg = argv[i];
+		if (Arg == "--iterations")
+			IterationCount = std::max(1, atoi(argv[i + 1]));
+		else if (Arg == "--filter")
+			Filter = argv[i + 1];
+		else if (Arg == "--output")
+			OutputFile = argv[i + 1];
+		else if (Arg == "--cache")
+			Cache = atoi(argv[i + 1]) != 0;
+		else if (Arg == "--lazy")
+			Lazy = atoi(argv[i + 1]) != 0;
+		else if (Arg == "--check-lazy")
+			CheckLazy = atoi(argv[i + 1]) != 0;
+		else if (Arg == "--async")
+			Async = atoi(argv[i + 1]) != 0;
+		else if (Arg == "--threads")
+			NumThreads = std::max(0, atoi(argv[i + 1]));
+		else if (Arg == "--min-parallel-tasks")
+			MinParallelTasks = std::max(0, atoi(argv[i + 1]));
+		else if (Arg == "--schedule")
+			SchedulePolicy = std::string(argv[i + 1]) == "memory" ? EGraphSchedulePolicy::MinimizeMemory : std::string(argv[i + 1]) == "distance" ? EGraphSchedulePolicy::MaximizeDistance : EGraphSchedulePolicy::RecordedOrder;
+	}
+
+	//the example RHI prints every command, keep that out of the measurements
+#ifdef _MSC_VER
+	(void)freopen("NUL", "w", stdout);
+#else
+	(void)freopen("/dev/null", "w", stdout);
+#endif
+
+	if (CheckLazy)
+	{
+		return CheckLazyBuilding(Filter, IterationCount);
+	}
+
+	TaskScheduler Scheduler(static_cast<U32>(NumThreads));
+
+	FILE* Output = fopen(OutputFile, "w");
+	if (Output == nullptr)
+	{
+		fprintf(stderr, "could not open %s\n", OutputFile);
+		return 1;
+	}
+
+	fprintf(stderr, "%-48s %8s %30s %30s %30s %20s\n", "scenario (us)", "actions", "build min/median/p99", "cull min/median/p99", "schedule min/median/p99", "live/aliased peak kb");
+	for (const Scenario& S : CreateScenarios())
+	{
+		if (S.Name.find(Filter) == std::string::npos)
+			continue;
+
+		ScenarioResult Result = RunScenario(S, IterationCount, Cache, Lazy, Async, NumThreads > 0 ? &Scheduler : nullptr, U32(MinParallelTasks), SchedulePolicy);
+
+		fprintf(stderr, "%-48s %8zu %10.2f%10.2f%10.2f %10.2f%10.2f%10.2f %10.2f%10.2f%10.2f %10llu%10llu\n", Result.Name.c_str(), Result.NumActions,
+			Result.Build.Percentile(0.0), Result.Build.Percentile(0.5), Result.Build.Percentile(0.99),
+			Result.Cull.Percentile(0.0), Result.Cull.Percentile(0.5), Result.Cull.Percentile(0.99),
+			Result.Schedule.Percentile(0.0), Result.Schedule.Percentile(0.5), Result.Schedule.Percentile(0.99),
+			(unsigned long long)(Result.LivePeakBytes / 1024), (unsigned long long)(Result.AliasedPeakBytes / 1024));
+
+		fprintf(Output, R"({ "scenario": "%s", "iterations": %d, "cache": %s, "lazy": %s, "threads": %d, "actions": %zu, "unit": "us", )", Result.Name.c_str(), IterationCount, Cache ? "true" : "false", Lazy ? "true" : "false", NumThreads, Result.NumActions);
+		WritePhase(Output, "build", Result.Build); fprintf(Output, ", ");
+		WritePhase(Output, "cull", Result.Cull); fprintf(Output, ", ");
+		WritePhase(Output, "schedule", Result.Schedule);
+		fprintf(Output, R"(, "memory": { "live_peak": %llu, "aliased_peak": %llu })", (unsigned long long)Result.LivePeakBytes, (unsigned long long)Result.AliasedPeakBytes);
+		if (Async)
+		{
+			fprintf(Output, R"(, "queues": { "serial": %llu, "parallel": %llu, "fences": %u })", (unsigned long long)Result.SerialQueueTime, (unsigned long long)Result.ParallelQueueTime, Result.NumFences);
+		}
+		fprintf(Output, " }\n");
+	}
+
+	fclose(Output);
+	return 0;
+}
@@ -0,0 +1,69 @@
+#include "ActionGraph.h"
+#include "Assert.h"
+#include <unordered_map>
+
+void ActionGraph::Compile(const std::vector<const IRenderPassAction*>& InAllActions)
+{
+	Nodes.assign(InAllActions.begin(), InAllActions.end());
+	EdgeOffsets.clear();
+	Edges.clear();
+	Resources.clear();
+
+	//the actions of a builder know their position in the list, other lists need a lookup
+	std::unordered_map<const IRenderPassAction*, U32> NodeIndices;
+	bool UseRecordIndices = true;
+	for (U32 i = 0; i < Nodes.size() && UseRecordIndices; i++)
+	{
+		UseRecordIndices = Nodes[i]->GetRecordIndex() == i;
+	}
+	if (!UseRecordIndices)
+	{
+		NodeIndices.reserve(Nodes.size());
+		for (U32 i = 0; i < Nodes.size(); i++)
+		{
+			NodeIndices.emplace(Nodes[i], i);
+		}
+	}
+
+	auto FindNode = [&](const IRenderPassAction* Action)
+	{
+		if (UseRecordIndices)
+		{
+			const U32 RecordIndex = Action->GetRecordIndex();
+			return RecordIndex < Nodes.size() && Nodes[RecordIndex] == Action ? RecordIndex : InvalidNode;
+		}
+		auto Iter = NodeIndices.find(Action);
+		return Iter != NodeIndices.end() ? Iter->second : InvalidNode;
+	};
+
+	EdgeOffsets.reserve(Nodes.size() + 1);
+	for (U32 i = 0; i < Nodes.size(); i++)
+	{
+		EdgeOffsets.push_back(U32(Edges.size()));
+		for (const ResourceTableEntry& Entry : Nodes[i]->GetRenderPassData())
+		{
+			Edge NewEdge;
+			NewEdge.Entry = Entry;
+			if (const TransientResourceBase* Resource = Entry.GetImaginaryResource())
+			{
+				if (Resource->GraphIndex >= Resources.size() || Resources[Resource->GraphIndex] != Resource)
+				{
+					Resource->GraphIndex = U32(Resources.size());
+					Resources.push_back(Resource);
+				}
+				NewEdge.Resource = Resource->GraphIndex;
+			}
+			if (!Entry.IsUndefined())
+			{
+				if (const IRenderPassAction* Parent = Entry.GetParent()->GetAction())
+				{
+					NewEdge.Producer = FindNode(Parent);
+					//actions are recorded after the actions they read from
+					check(NewEdge.Producer == InvalidNode || NewEdge.Producer <= i);
+				}
+			}
+			Edges.push_back(NewEdge);
+		}
+	}
+	EdgeOffsets.push_back(U32(Edges.size()));
+}
\ No newline at end of file
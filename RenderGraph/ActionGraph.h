@@ -0,0 +1,70 @@
+#pragma once
+#include "Renderpass.h"
+#include "Plumber.h"
+#include "Types.h"
+#include <vector>
+
+/* A compact adjacency representation (CSR) of the recorded actions */
+/* the nodes are the indices into the action list and every node owns a contiguous range of its table entries */
+/* entries that were written by another action in the list point at their producer node */
+/* the resources of all entries get dense ids in the order they are first touched */
+struct ActionGraph
+{
+	static constexpr U32 InvalidNode = ~0u;
+	static constexpr U32 InvalidResource = ~0u;
+
+	struct Edge
+	{
+		ResourceTableEntry Entry;
+		U32 Producer = InvalidNode;
+		U32 Resource = InvalidResource;
+	};
+
+	struct EdgeRange
+	{
+		const Edge* First = nullptr;
+		const Edge* Last = nullptr;
+
+		const Edge* begin() const { return First; }
+		const Edge* end() const { return Last; }
+		size_t size() const { return Last - First; }
+	};
+
+	void Compile(const std::vector<const IRenderPassAction*>& InAllActions);
+
+	U32 GetNumNodes() const
+	{
+		return U32(Nodes.size());
+	}
+
+	const IRenderPassAction* GetAction(U32 Node) const
+	{
+		return Nodes[Node];
+	}
+
+	EdgeRange GetEdges(U32 Node) const
+	{
+		return { Edges.data() + EdgeOffsets[Node], Edges.data() + EdgeOffsets[Node + 1] };
+	}
+
+	U32 GetNumResources() const
+	{
+		return U32(Resources.size());
+	}
+
+	const TransientResourceBase* GetResource(U32 Resource) const
+	{
+		return Resources[Resource];
+	}
+
+	const std::vector<const TransientResourceBase*>& GetResources() const
+	{
+		return Resources;
+	}
+
+private:
+	std::vector<const IRenderPassAction*> Nodes;
+	std::vector<U32> EdgeOffsets;
+	std::vector<Edge> Edges;
+	std::vector<const TransientResourceBase*> Resources;
+};
\ No newline at end of file
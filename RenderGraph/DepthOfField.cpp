@@ -82,7 +82,14 @@ auto HybridScatteringLayerProcessing(const RenderPassBuilder& Builder, const Sce
 template<typename BokehLUTType>
 auto BuildBokehLut(const RenderPassBuilder& Builder, const SceneViewInfo& ViewInfo)
 {
-	return Seq([&Builder, &ViewInfo](const auto& s)
+	//the task lives outside of the generic lambda, so every LUT of the same type shares one task type and duplicates can be merged
+	using BuildBokehLUTData = ResourceTable<BokehLUTType>;
+	auto BuildBokehLUTTask = [](RenderContext& Ctx, const BuildBokehLUTData&)
+	{
+		Ctx.Draw("BuildBokehLUTAction");
+	};
+
+	return Seq([&Builder, &ViewInfo, BuildBokehLUTTask](const auto& s)
 	{
 		CheckIsValidResourceTable(s);
 
@@ -96,11 +103,7 @@ auto BuildBokehLut(const RenderPassBuilder& Builder, const SceneViewInfo& ViewIn
 
 		if (!ViewInfo.DofSettings.BokehShapeIsCircle)
 		{
-			using BuildBokehLUTData = ResourceTable<BokehLUTType>;
-			LutOutputTable = Builder.QueueRenderAction("BuildBokehLUTAction", [](RenderContext& Ctx, const BuildBokehLUTData&)
-			{
-				Ctx.Draw("BuildBokehLUTAction");
-			})(LutOutputTable);
+			LutOutputTable = Builder.QueueRenderAction("BuildBokehLUTAction", BuildBokehLUTTask, ERenderActionFlags::Deduplicate)(LutOutputTable);
 		}
 		return LutOutputTable;
 	});
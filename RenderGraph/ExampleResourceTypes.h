@@ -2,7 +2,8 @@
 #include "Types.h"
 #include "Plumber.h"
 #include "LinearAlloc.h"
-#include <unordered_map>
+#include "ResourcePool.h"
+#include "ExternalResourceRegistry.h"
 /* example Texture2d implementation */
 struct Texture2d : MaterializedResource
 {
@@ -28,6 +29,19 @@ struct Texture2d : MaterializedResource
 
 		ERenderResourceFormat::Type Format = ERenderResourceFormat::Invalid;
 
+		/* the memory footprint of the whole texture including all mips and slices */
+		U64 GetByteSize() const
+		{
+			U64 BytesPerSlice = 0;
+			for (U32 Mip = 0; Mip < MipLevel; Mip++)
+			{
+				U64 MipWidth = (Width >> Mip) ? (Width >> Mip) : 1;
+				U64 MipHeight = (Height >> Mip) ? (Height >> Mip) : 1;
+				BytesPerSlice += MipWidth * MipHeight * ERenderResourceFormat::GetBytesPerPixel(Format);
+			}
+			return BytesPerSlice * TexSlices;
+		}
+
 		bool operator==(const Descriptor& Other) const
 		{
 			if (Format != Other.Format)
@@ -39,6 +53,9 @@ struct Texture2d : MaterializedResource
 			if (Height != Other.Height)
 				return false;
 
+			if (MipLevel != Other.MipLevel || TexSlices != Other.TexSlices)
+				return false;
+
 			if (strcmp(Name, Other.Name) != 0)
 				return false;
 
@@ -50,13 +67,54 @@ struct Texture2d : MaterializedResource
 		: MaterializedResource(InResourceFlags), Desc(InDesc)
 	{}
 
+	/* everything but the name has to match to recycle a pooled resource */
+	static U64 GetPoolHash(const Descriptor& InDesc)
+	{
+		U64 Hash = U64(InDesc.Format.GetEnum());
+		Hash = Hash * 1610612741 + InDesc.Width;
+		Hash = Hash * 1610612741 + InDesc.Height;
+		Hash = Hash * 1610612741 + InDesc.MipLevel;
+		Hash = Hash * 1610612741 + InDesc.TexSlices;
+		return Hash;
+	}
+
+	bool IsPoolCompatible(const Descriptor& InDesc, EResourceFlags::Type InResourceFlags) const
+	{
+		return Desc.Format == InDesc.Format 
+			&& Desc.Width == InDesc.Width 
+			&& Desc.Height == InDesc.Height 
+			&& Desc.MipLevel == InDesc.MipLevel 
+			&& Desc.TexSlices == InDesc.TexSlices
+			&& GetResourceFlags() == InResourceFlags;
+	}
+
+	/* a recycled texture starts the frame like a new one, the state of the last frame says nothing about what the new owner needs */
+	void Recycle(const Descriptor& InDesc)
+	{
+		check(IsPoolCompatible(InDesc, GetResourceFlags()) && !HasBegunTransition);
+		Desc.Name = InDesc.Name;
+		CurrentState = EResourceTransition::Undefined;
+	}
+
 	const char* GetName() const
 	{
 		return Desc.Name;
 	}
 
+	const Descriptor& GetDescriptor() const
+	{
+		return Desc;
+	}
+
+	EResourceTransition::Type GetCurrentState() const
+	{
+		return CurrentState;
+	}
+
 	bool RequiresTransition(EResourceTransition::Type& OldState, EResourceTransition::Type NewState) const
 	{
+		//a begun split transition has to be ended before the texture goes anywhere else
+		check(!HasBegunTransition);
 		if (NewState != CurrentState)
 		{
 			OldState = CurrentState;
@@ -66,9 +124,37 @@ struct Texture2d : MaterializedResource
 		return false;
 	}
 
+	/* the first half of a split transition, the texture must not be used until EndTransition to the same state */
+	bool BeginTransition(EResourceTransition::Type& OldState, EResourceTransition::Type NewState) const
+	{
+		if (NewState != CurrentState && !HasBegunTransition)
+		{
+			OldState = CurrentState;
+			BegunState = NewState;
+			HasBegunTransition = true;
+			return true;
+		}
+		return false;
+	}
+
+	/* returns false if no transition to NewState was begun */
+	bool EndTransition(EResourceTransition::Type& OldState, EResourceTransition::Type NewState) const
+	{
+		if (HasBegunTransition && BegunState == NewState)
+		{
+			OldState = CurrentState;
+			CurrentState = NewState;
+			HasBegunTransition = false;
+			return true;
+		}
+		return false;
+	}
+
 private:
 	Descriptor Desc;
 	mutable EResourceTransition::Type CurrentState = EResourceTransition::Undefined;
+	mutable EResourceTransition::Type BegunState = EResourceTransition::Undefined;
+	mutable bool HasBegunTransition = false;
 };
 
 struct TransientTexture2d
@@ -98,6 +184,11 @@ struct TransientTexture2d
 	{
 		return ResourceDescriptor.MipLevel * ResourceDescriptor.TexSlices;
 	}
+
+	static U64 GetByteSize(const DescriptorType& ResourceDescriptor)
+	{
+		return ResourceDescriptor.GetByteSize();
+	}
 };
 
 template<typename CompatibleType>
@@ -108,6 +199,8 @@ struct Texture2dResourceHandle : ResourceHandle<CompatibleType>
 	using ResourceType = typename TransientResourceType::ResourceType;
 
 	static constexpr bool IsOutputResource = false;
+	/* rendertargets need the rasterizer, everything else can be bound on the async compute queue as well */
+	static constexpr bool RequiresGraphicsQueue = false;
 
 	template<typename HandleType>
 	static TransientResourceImpl<HandleType>* OnCreate(const typename HandleType::DescriptorType& InDescriptor)
@@ -117,10 +210,12 @@ struct Texture2dResourceHandle : ResourceHandle<CompatibleType>
 
 	static ResourceType* OnMaterialize(const DescriptorType& Descriptor)
 	{
-		return LinearNew<ResourceType>(Descriptor, EResourceFlags::Managed);
+		return TransientResourcePool<ResourceType>::Get().Acquire(Descriptor, EResourceFlags::Managed);
 	}
 
-	static void OnExecute(struct ImmediateRenderContext& Ctx, const ResourceType& Resource, U32 SubResourceIndex)
+	/* the context is a template parameter so the handles do not depend on the RHI header */
+	template<typename RenderContextType>
+	static void OnExecute(RenderContextType& Ctx, const ResourceType& Resource, U32 SubResourceIndex)
 	{
 		Ctx.TransitionResource(Resource, EResourceTransition::Texture);
 		Ctx.BindTexture(Resource, SubResourceIndex);
@@ -140,7 +235,8 @@ struct Uav2dResourceHandle : Texture2dResourceHandle<CompatibleType>
 {
 	static constexpr bool IsOutputResource = true;
 
-	static void OnExecute(ImmediateRenderContext& Ctx, const typename Texture2dResourceHandle<CompatibleType>::ResourceType& Resource, U32 SubResourceIndex)
+	template<typename RenderContextType>
+	static void OnExecute(RenderContextType& Ctx, const typename Texture2dResourceHandle<CompatibleType>::ResourceType& Resource, U32 SubResourceIndex)
 	{
 		Ctx.TransitionResource(Resource, EResourceTransition::UAV);
 		Ctx.BindTexture(Resource, SubResourceIndex);
@@ -151,8 +247,10 @@ template<typename CompatibleType>
 struct RendertargetResourceHandle : Texture2dResourceHandle<CompatibleType>
 {
 	static constexpr bool IsOutputResource = true;
+	static constexpr bool RequiresGraphicsQueue = true;
 
-	static void OnExecute(ImmediateRenderContext& Ctx, const typename Texture2dResourceHandle<CompatibleType>::ResourceType& Resource, U32 SubResourceIndex)
+	template<typename RenderContextType>
+	static void OnExecute(RenderContextType& Ctx, const typename Texture2dResourceHandle<CompatibleType>::ResourceType& Resource, U32 SubResourceIndex)
 	{
 		check(SubResourceIndex != ALL_SUBRESOURCE_INDICIES);
 		Ctx.TransitionResource(Resource, EResourceTransition::Target);
@@ -197,16 +295,7 @@ struct ExternalTexture2dResourceHandle : Texture2dResourceHandle<CompatibleType>
 
 	static ResourceType* OnMaterialize(const DescriptorType& Descriptor)
 	{
-		//TODO static string key is not really safe
-		static std::unordered_map<const char*, ResourceType*> ExternalResourceMap;
-		auto it = ExternalResourceMap.find(Descriptor.Name);
-		if (it == ExternalResourceMap.end())
-		{
-			ResourceType* ExternalResource = new ResourceType(Descriptor, EResourceFlags::External);
-			ExternalResourceMap[Descriptor.Name] = ExternalResource;
-			return ExternalResource;
-		}
-		return it->second;
+		return ExternalResourceRegistry<ResourceType>::Get().FindOrCreate(Descriptor, EResourceFlags::External);
 	}
 };
 
@@ -215,7 +304,8 @@ struct ExternalUav2dResourceHandle : ExternalTexture2dResourceHandle<CompatibleT
 {
 	static constexpr bool IsOutputResource = true;
 
-	static void OnExecute(ImmediateRenderContext& Ctx, const typename ExternalTexture2dResourceHandle<CompatibleType>::ResourceType& Resource, U32 SubResourceIndex)
+	template<typename RenderContextType>
+	static void OnExecute(RenderContextType& Ctx, const typename ExternalTexture2dResourceHandle<CompatibleType>::ResourceType& Resource, U32 SubResourceIndex)
 	{
 		Ctx.TransitionResource(Resource, EResourceTransition::UAV);
 		Ctx.BindTexture(Resource, SubResourceIndex);
@@ -226,8 +316,10 @@ template<typename CompatibleType>
 struct ExternalRendertargetResourceHandle : ExternalTexture2dResourceHandle<CompatibleType>
 {
 	static constexpr bool IsOutputResource = true;
+	static constexpr bool RequiresGraphicsQueue = true;
 
-	static void OnExecute(ImmediateRenderContext& Ctx, const typename ExternalTexture2dResourceHandle<CompatibleType>::ResourceType& Resource, U32 SubResourceIndex)
+	template<typename RenderContextType>
+	static void OnExecute(RenderContextType& Ctx, const typename ExternalTexture2dResourceHandle<CompatibleType>::ResourceType& Resource, U32 SubResourceIndex)
 	{
 		check(SubResourceIndex != ALL_SUBRESOURCE_INDICIES);
 		Ctx.TransitionResource(Resource, EResourceTransition::Target);
@@ -260,7 +352,8 @@ struct DepthTexture2dResourceHandle : Texture2dResourceHandle<CompatibleType>
 {
 	static constexpr bool IsOutputResource = false;
 
-	static void OnExecute(ImmediateRenderContext& Ctx, const typename Texture2dResourceHandle<CompatibleType>::ResourceType& Resource, U32 SubResourceIndex)
+	template<typename RenderContextType>
+	static void OnExecute(RenderContextType& Ctx, const typename Texture2dResourceHandle<CompatibleType>::ResourceType& Resource, U32 SubResourceIndex)
 	{
 		Ctx.TransitionResource(Resource, EResourceTransition::DepthTexture);
 		Ctx.BindTexture(Resource, SubResourceIndex);
@@ -278,7 +371,8 @@ struct DepthUav2dResourceHandle : DepthTexture2dResourceHandle<CompatibleType>
 {
 	static constexpr bool IsOutputResource = true;
 
-	static void OnExecute(ImmediateRenderContext& Ctx, const typename DepthTexture2dResourceHandle<CompatibleType>::ResourceType& Resource, U32 SubResourceIndex)
+	template<typename RenderContextType>
+	static void OnExecute(RenderContextType& Ctx, const typename DepthTexture2dResourceHandle<CompatibleType>::ResourceType& Resource, U32 SubResourceIndex)
 	{
 		Ctx.TransitionResource(Resource, EResourceTransition::UAV);
 		Ctx.BindTexture(Resource, SubResourceIndex);
@@ -289,8 +383,10 @@ template<typename CompatibleType>
 struct DepthRendertargetResourceHandle : DepthTexture2dResourceHandle<CompatibleType>
 {
 	static constexpr bool IsOutputResource = true;
+	static constexpr bool RequiresGraphicsQueue = true;
 
-	static void OnExecute(ImmediateRenderContext& Ctx, const typename DepthTexture2dResourceHandle<CompatibleType>::ResourceType& Resource, U32 SubResourceIndex)
+	template<typename RenderContextType>
+	static void OnExecute(RenderContextType& Ctx, const typename DepthTexture2dResourceHandle<CompatibleType>::ResourceType& Resource, U32 SubResourceIndex)
 	{
 		check(SubResourceIndex != ALL_SUBRESOURCE_INDICIES);
 		Ctx.TransitionResource(Resource, EResourceTransition::DepthTarget);
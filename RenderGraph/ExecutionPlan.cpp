@@ -0,0 +1,67 @@
+#include "ExecutionPlan.h"
+#include "Renderpass.h"
+#include <algorithm>
+#include <unordered_map>
+
+void ExecutionPlan::Compile(const std::vector<const IRenderPassAction*>& InSchedule)
+{
+	Commands.clear();
+	ActionCommands.clear();
+	BeginBarriers.clear();
+	if (SplitBarriers)
+	{
+		PlaceSplitBarriers(InSchedule);
+	}
+
+	auto NextBeginBarrier = BeginBarriers.begin();
+	for (U32 i = 0; i < InSchedule.size(); i++)
+	{
+		ActionCommands.push_back(U32(Commands.size()));
+		//the begin halves go into the batch of this action, they are gathered before its own transitions
+		for (; NextBeginBarrier != BeginBarriers.end() && NextBeginBarrier->Position == i; ++NextBeginBarrier)
+		{
+			AddCommand(&ExecuteBeginBarrier, NextBeginBarrier->Texture, NextBeginBarrier->Transition);
+		}
+		InSchedule[i]->CompileCommands(*this);
+	}
+	ActionCommands.push_back(U32(Commands.size()));
+}
+
+void ExecutionPlan::PlaceSplitBarriers(const std::vector<const IRenderPassAction*>& InSchedule)
+{
+	//the state every texture will be in and the last action that used it, starting from the state the textures are in now
+	struct TextureUse
+	{
+		U32 LastUse;
+		EResourceTransition::Type State;
+	};
+	std::unordered_map<const Texture2d*, TextureUse> Uses;
+
+	for (U32 i = 0; i < InSchedule.size(); i++)
+	{
+		ActionBarriers.clear();
+		InSchedule[i]->GatherBarriers(ActionBarriers);
+		for (const ResourceBarrier& Barrier : ActionBarriers)
+		{
+			auto Iter = Uses.try_emplace(Barrier.Texture, TextureUse{ UINT_MAX, Barrier.Texture->GetCurrentState() }).first;
+			TextureUse& Use = Iter->second;
+			if (Barrier.Transition != Use.State)
+			{
+				//the first use in the frame has no earlier action to start after, the memory might still belong to an aliased resource
+				if (Use.LastUse != UINT_MAX && Use.LastUse + 1 < i)
+				{
+					BeginBarriers.push_back({ Use.LastUse + 1, Barrier.Texture, U32(Barrier.Transition) });
+				}
+				Use.State = Barrier.Transition;
+			}
+			Use.LastUse = i;
+		}
+	}
+
+	std::stable_sort(BeginBarriers.begin(), BeginBarriers.end(), [](const BeginBarrier& A, const BeginBarrier& B) { return A.Position < B.Position; });
+}
+
+void ExecutionPlan::ExecuteBeginBarrier(CommandRenderContext& RndCtx, const Command& Cmd)
+{
+	RndCtx.AddBarrier(*static_cast<const Texture2d*>(Cmd.Object), EResourceTransition::Type(Cmd.SubResourceIndex), EBarrierType::Begin);
+}
\ No newline at end of file
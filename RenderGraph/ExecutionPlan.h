@@ -0,0 +1,100 @@
+#pragma once
+#include "Types.h"
+#include <vector>
+
+struct IRenderPassAction;
+struct CommandRenderContext;
+struct Texture2d;
+struct ResourceBarrier;
+
+/* a scheduled graph flattened into one contiguous array of transitions, binds and task invocations */
+/* compiling resolves the materialized resources once, replaying is a loop over plain function pointers */
+class ExecutionPlan
+{
+public:
+	struct Command;
+	using CommandFunction = void(*)(CommandRenderContext&, const Command&);
+
+	struct Command
+	{
+		CommandFunction Function = nullptr;
+		/* the materialized resource for handle commands or the action for task commands */
+		const void* Object = nullptr;
+		U32 SubResourceIndex = 0;
+	};
+
+	/* needs the materialization of a culled graph, the resources are only valid for the frame they were compiled in */
+	void Compile(const std::vector<const IRenderPassAction*>& InSchedule);
+
+	/* a transition of a texture that was last used more than one action earlier begins in the batch right after that use */
+	/* and ends in the batch of the action that needs it, adjacent uses and the first use in a frame keep a normal barrier */
+	void SetSplitBarriers(bool InSplitBarriers)
+	{
+		SplitBarriers = InSplitBarriers;
+	}
+
+	/* how many transitions the last Compile split */
+	U32 GetNumSplitBarriers() const
+	{
+		return U32(BeginBarriers.size());
+	}
+
+	void Execute(CommandRenderContext& RndCtx) const
+	{
+		for (const Command& Cmd : Commands)
+		{
+			Cmd.Function(RndCtx, Cmd);
+		}
+	}
+
+	/* the commands of one action of the schedule, actions can be recorded on any thread as long as each context is only used by one */
+	void ExecuteAction(CommandRenderContext& RndCtx, U32 ActionIndex) const
+	{
+		for (U32 i = ActionCommands[ActionIndex]; i < ActionCommands[ActionIndex + 1]; i++)
+		{
+			Commands[i].Function(RndCtx, Commands[i]);
+		}
+	}
+
+	void AddCommand(CommandFunction Function, const void* Object, U32 SubResourceIndex = 0)
+	{
+		Commands.push_back({ Function, Object, SubResourceIndex });
+	}
+
+	size_t GetNumCommands() const
+	{
+		return Commands.size();
+	}
+
+	U32 GetNumActions() const
+	{
+		return U32(ActionCommands.size()) - 1;
+	}
+
+	void Reset()
+	{
+		Commands.clear();
+		ActionCommands.assign(1, 0);
+		BeginBarriers.clear();
+	}
+
+private:
+	/* the begin half of a split transition, issued with the barriers of the action at Position */
+	struct BeginBarrier
+	{
+		U32 Position;
+		const Texture2d* Texture;
+		U32 Transition;
+	};
+
+	void PlaceSplitBarriers(const std::vector<const IRenderPassAction*>& InSchedule);
+	static void ExecuteBeginBarrier(CommandRenderContext& RndCtx, const Command& Cmd);
+
+	bool SplitBarriers = false;
+	std::vector<BeginBarrier> BeginBarriers;
+	std::vector<ResourceBarrier> ActionBarriers;
+
+	std::vector<Command> Commands;
+	/* the first command of every action in the schedule and the end of the last one */
+	std::vector<U32> ActionCommands = { 0 };
+};
\ No newline at end of file
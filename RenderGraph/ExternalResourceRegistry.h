@@ -0,0 +1,165 @@
+#pragma once
+#include "Types.h"
+#include "Assert.h"
+#include "LinearAlloc.h"
+#include <cstring>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/* a string table where equal strings share the same pointer, so interned names can be compared and hashed by address */
+struct InternedStrings
+{
+	static const char* Intern(const char* Str)
+	{
+		static InternedStrings* Strings = new InternedStrings();
+		return Strings->InternInternal(Str);
+	}
+
+private:
+	const char* InternInternal(const char* Str)
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		std::string_view View(Str);
+		auto Iter = Table.find(View);
+		if (Iter != Table.end())
+		{
+			return Iter->second;
+		}
+
+		char* Copy = new char[View.size() + 1];
+		memcpy(Copy, Str, View.size() + 1);
+		Table[std::string_view(Copy, View.size())] = Copy;
+		return Copy;
+	}
+
+	std::mutex Mutex;
+	std::unordered_map<std::string_view, const char*> Table;
+};
+
+/* Owns the external resources (like history buffers) that have to persist between frames, they are looked up by the name of their descriptor */
+/* Names that were interned up front are found with a single pointer hash, all other names are interned on their first lookup */
+/* a lookup with the same name but another descriptor (e.g. after a resize) replaces the resource, the ResourceType has to provide GetDescriptor() */
+/* replaced, released and evicted resources are only deleted once the frames that might still use them are done */
+template<typename ResourceType>
+class ExternalResourceRegistry
+{
+	using DescriptorType = typename ResourceType::Descriptor;
+
+	struct RegisteredResource
+	{
+		ResourceType* Resource = nullptr;
+		U64 LastUsedFrame = 0;
+	};
+
+	struct RetiredResource
+	{
+		ResourceType* Resource = nullptr;
+		U64 RetiredFrame = 0;
+	};
+
+public:
+	/* external resources that were not requested for this many frames are evicted */
+	static constexpr U64 DefaultMaxUnusedFrames = 60;
+
+	static ExternalResourceRegistry& Get()
+	{
+		static ExternalResourceRegistry* Registry = new ExternalResourceRegistry();
+		return *Registry;
+	}
+
+	ExternalResourceRegistry(const ExternalResourceRegistry&) = delete;
+
+	ResourceType* FindOrCreate(const DescriptorType& Descriptor, EResourceFlags::Type ResourceFlags)
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		auto Iter = Resources.find(Descriptor.Name);
+		if (Iter == Resources.end())
+		{
+			//not an interned pointer, or the resource does not exist yet
+			Iter = Resources.find(InternedStrings::Intern(Descriptor.Name));
+		}
+
+		if (Iter == Resources.end())
+		{
+			DescriptorType InternedDescriptor = Descriptor;
+			InternedDescriptor.Name = InternedStrings::Intern(Descriptor.Name);
+			RegisteredResource NewEntry;
+			NewEntry.Resource = new ResourceType(InternedDescriptor, ResourceFlags);
+			Iter = Resources.emplace(InternedDescriptor.Name, NewEntry).first;
+		}
+		else if (!(Iter->second.Resource->GetDescriptor() == Descriptor))
+		{
+			DescriptorType InternedDescriptor = Descriptor;
+			InternedDescriptor.Name = Iter->first;
+			Retire(Iter->second.Resource);
+			Iter->second.Resource = new ResourceType(InternedDescriptor, ResourceFlags);
+		}
+
+		Iter->second.LastUsedFrame = CurrentFrame;
+		return Iter->second.Resource;
+	}
+
+	/* explicitly free an external resource, e.g. when a view is destroyed */
+	void Release(const char* Name)
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		auto Iter = Resources.find(InternedStrings::Intern(Name));
+		if (Iter != Resources.end())
+		{
+			Retire(Iter->second.Resource);
+			Resources.erase(Iter);
+		}
+	}
+
+	/* call once per frame after the graph executed, this evicts the resources nobody asked for recently */
+	void NextFrame(U64 MaxUnusedFrames = DefaultMaxUnusedFrames)
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		for (auto Iter = Resources.begin(); Iter != Resources.end();)
+		{
+			if (CurrentFrame - Iter->second.LastUsedFrame >= MaxUnusedFrames)
+			{
+				Retire(Iter->second.Resource);
+				Iter = Resources.erase(Iter);
+			}
+			else
+			{
+				++Iter;
+			}
+		}
+
+		//the frame that retired a resource and the ones after it might still be in flight, just like their linear arenas
+		for (size_t i = 0; i < RetiredResources.size();)
+		{
+			if (CurrentFrame - RetiredResources[i].RetiredFrame >= NUM_LINEAR_ALLOC_FRAMES)
+			{
+				delete RetiredResources[i].Resource;
+				RetiredResources[i] = RetiredResources.back();
+				RetiredResources.pop_back();
+				continue;
+			}
+			i++;
+		}
+		CurrentFrame++;
+	}
+
+	U32 GetNumResources() const
+	{
+		return U32(Resources.size());
+	}
+
+private:
+	ExternalResourceRegistry() {}
+
+	void Retire(ResourceType* Resource)
+	{
+		RetiredResources.push_back({ Resource, CurrentFrame });
+	}
+
+	std::mutex Mutex;
+	std::unordered_map<const char*, RegisteredResource> Resources;
+	std::vector<RetiredResource> RetiredResources;
+	U64 CurrentFrame = 0;
+};
@@ -1,60 +1,170 @@
 #include "GraphCulling.h"
 #include "Plumber.h"
 #include "Renderpass.h"
+#include <algorithm>
 
-bool GraphProcessor::ColorGraphNodesInternal(const IRenderPassAction* Action, std::vector<const IRenderPassAction*>& InAllActions)
+void GraphProcessor::ColorGraphNodes(const std::vector<const IRenderPassAction*>& InAllActions)
 {
-	const IResourceTableInfo& Pass = Action->GetRenderPassData();
-	bool isFirstPath = true;
+	if (InAllActions.size() > 1)
+	{
+		Graph.Compile(InAllActions);
+		ProcessedNodes.assign(Graph.GetNumNodes(), false);
+		BeginMaterialization();
+
+		//a processor that is kept over several graphs colors every full walk the same
+		CurrentColor = 1;
+		ColorGraphNodesInternal(Graph.GetNumNodes() - 1);
+		MaterializeLiveResources(Graph.GetResources());
+	}
+}
+
+void GraphProcessor::BeginMaterialization()
+{
+	const U32 NumResources = Graph.GetNumResources();
+	LiveResources.assign(NumResources, false);
+	MarkedResources.assign(NumResources, false);
+	MarkedOrder.clear();
+
+	LiveWordOffsets.assign(NumResources + 1, 0);
+	for (U32 Resource = 0; Resource < NumResources; Resource++)
+	{
+		LiveWordOffsets[Resource + 1] = LiveWordOffsets[Resource] + Graph.GetResource(Resource)->GetNumSubResourceWords();
+	}
+
+	LiveSubResources.resize(LiveWordOffsets[NumResources]);
+	for (U32 Resource = 0; Resource < NumResources; Resource++)
+	{
+		LiveResources[Resource] = Graph.GetResource(Resource)->GetMaterializedSubResources(&LiveSubResources[LiveWordOffsets[Resource]]);
+	}
+}
+
+/* same answer as ResourceTableEntry::IsMaterialized, but for the state of the walk */
+bool GraphProcessor::IsLive(const ActionGraph::Edge& Edge) const
+{
+	if (Edge.Resource == ActionGraph::InvalidResource || !LiveResources[Edge.Resource])
+	{
+		return false;
+	}
 
-	U32 NumValidMutables = 0;
-	for (const ResourceTableEntry& Output : Pass)
+	const U32 SubResourceIndex = Edge.Entry.GetSubResourceIndex();
+	if (SubResourceIndex == ALL_SUBRESOURCE_INDICIES)
 	{
-		if (Output.IsOutput() && Output.IsMaterialized())
+		for (U32 i = LiveWordOffsets[Edge.Resource]; i < LiveWordOffsets[Edge.Resource + 1]; i++)
 		{
-			NumValidMutables++;
+			if (LiveSubResources[i] != ~0ull)
+			{
+				return false;
+			}
 		}
+		return true;
 	}
+	return (LiveSubResources[LiveWordOffsets[Edge.Resource] + SubResourceIndex / 64] >> (SubResourceIndex % 64)) & 1ull;
+}
 
-	//Statics only need to be processed for Leafs
-	if (Action != nullptr)
+void GraphProcessor::MarkLive(const ActionGraph::Edge& Edge)
+{
+	check(Edge.Resource != ActionGraph::InvalidResource);
+	if (!MarkedResources[Edge.Resource])
 	{
-		for (const ResourceTableEntry& Input : Pass)
+		MarkedResources[Edge.Resource] = true;
+		MarkedOrder.push_back(Edge.Resource);
+	}
+	LiveResources[Edge.Resource] = true;
+
+	const U32 SubResourceIndex = Edge.Entry.GetSubResourceIndex();
+	if (SubResourceIndex == ALL_SUBRESOURCE_INDICIES)
+	{
+		std::fill(LiveSubResources.begin() + LiveWordOffsets[Edge.Resource], LiveSubResources.begin() + LiveWordOffsets[Edge.Resource + 1], ~0ull);
+	}
+	else
+	{
+		LiveSubResources[LiveWordOffsets[Edge.Resource] + SubResourceIndex / 64] |= 1ull << (SubResourceIndex % 64);
+	}
+}
+
+void GraphProcessor::MaterializeLiveResources(const std::vector<const TransientResourceBase*>& Resources)
+{
+	for (U32 Resource : MarkedOrder)
+	{
+		Resources[Resource]->MaterializeSubResources(&LiveSubResources[LiveWordOffsets[Resource]]);
+	}
+}
+
+void GraphProcessor::PushColorFrame(U32 Node)
+{
+	ColorFrame Frame;
+	Frame.Node = Node;
+	Frame.NextEdge = 0;
+	Frame.NumValidMutables = 0;
+	Frame.Child = ActionGraph::InvalidNode;
+	Frame.isFirstPath = true;
+
+	for (const ActionGraph::Edge& Output : Graph.GetEdges(Node))
+	{
+		if (Output.Entry.IsOutput() && IsLive(Output))
 		{
-			if (!Input.IsUndefined())
+			Frame.NumValidMutables++;
+		}
+	}
+
+	ColorStack.push_back(Frame);
+}
+
+void GraphProcessor::ColorGraphNodesInternal(U32 Root)
+{
+	ColorStack.clear();
+	PushColorFrame(Root);
+
+	while (!ColorStack.empty())
+	{
+		ColorFrame& Frame = ColorStack.back();
+		const ActionGraph::EdgeRange Edges = Graph.GetEdges(Frame.Node);
+
+		U32 Parent = ActionGraph::InvalidNode;
+		while (Frame.NextEdge < Edges.size() && Parent == ActionGraph::InvalidNode)
+		{
+			const ActionGraph::Edge& Input = Edges.First[Frame.NextEdge++];
+			if (!Input.Entry.IsUndefined())
 			{
-				if (NumValidMutables)
+				if (Frame.NumValidMutables)
 				{
-					Input.Materialize();
+					MarkLive(Input);
 				}
 
-				if (const IRenderPassAction* Parent = Input.GetParent() ? Input.GetParent()->GetAction() : nullptr)
+				if (Input.Producer != ActionGraph::InvalidNode && Input.Producer != Frame.Node && !ProcessedNodes[Input.Producer])
 				{
-					auto Iter = std::find(InAllActions.begin(), InAllActions.end(), Parent);
-					if (Iter != InAllActions.end() && *Iter != Action)
-					{
-						if (!isFirstPath)
-						{
-							NextColor();
-						}
-
-						isFirstPath &= ColorGraphNodesInternal(*Iter, InAllActions);
-						Iter = std::find(InAllActions.begin(), InAllActions.end(), Parent);
-						if (Iter != InAllActions.end())
-						{
-							InAllActions.erase(Iter);
-						}
-					}
+					Parent = Input.Producer;
 				}
 			}
 		}
 
-		if (NumValidMutables && (Action->GetColor() == UINT32_MAX || Action->GetColor() < CurrentColor))
+		if (Parent != ActionGraph::InvalidNode)
+		{
+			if (!Frame.isFirstPath)
+			{
+				NextColor();
+			}
+
+			Frame.Child = Parent;
+			PushColorFrame(Parent);
+			continue;
+		}
+
+		//all producers are done, resolve this node and hand the result to the node that walked into it
+		bool isFirstPath = Frame.isFirstPath;
+		const IRenderPassAction* Action = Graph.GetAction(Frame.Node);
+		if (Frame.NumValidMutables && (Action->GetColor() == UINT32_MAX || Action->GetColor() < CurrentColor))
 		{
 			Action->SetColor(CurrentColor);
-			return false;
+			isFirstPath = false;
 		}
-	}
 
-	return isFirstPath;
+		ColorStack.pop_back();
+		if (!ColorStack.empty())
+		{
+			ColorFrame& Caller = ColorStack.back();
+			Caller.isFirstPath &= isFirstPath;
+			ProcessedNodes[Caller.Child] = true;
+		}
+	}
 }
\ No newline at end of file
@@ -1,37 +1,226 @@
 #pragma once
 #include "Renderpass.h"
+#include "ActionGraph.h"
+#include "ExecutionPlan.h"
+#include "QueueAssignment.h"
+#include "WorkStealingQueue.h"
 #include "Types.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <vector>
-#include <algorithm>
+#include <unordered_map>
 
 struct LeafRenderPass;
 
+/* order in which ScheduleGraphNodes executes the actions that survived culling, all policies keep the dependencies between actions */
+enum class EGraphSchedulePolicy
+{
+	RecordedOrder,		/* the order the actions were recorded in */
+	MinimizeMemory,		/* greedily run the action that adds the least live transient memory, so resources die as early as possible, then move actions that allocate too early behind the peak */
+	MaximizeDistance,	/* prefer actions whose inputs were produced the longest time ago, so consumers move away from their producers */
+};
+
 struct GraphProcessor
 {
-	void ColorGraphNodes(const std::vector<const IRenderPassAction*>& InAllActions)
+	void ColorGraphNodes(const std::vector<const IRenderPassAction*>& InAllActions);
+
+	/* a graph that matches an earlier graph entry by entry takes the cached colors and schedule, neither culling nor scheduling runs */
+	/* the builder has to record its graph keys, the structural hash finds the candidate and the keys verify it without compiling the graph */
+	void ColorGraphNodes(const RenderPassBuilder& Builder);
+	void ScheduleGraphNodes(ImmediateRenderContext& RndCtx, const RenderPassBuilder& Builder);
+
+	U32 GetNumCacheHits() const
+	{
+		return NumCacheHits;
+	}
+
+	void SetSchedulePolicy(EGraphSchedulePolicy InSchedulePolicy)
+	{
+		SchedulePolicy = InSchedulePolicy;
+	}
+
+	/* every scheduled action becomes a task that waits for the actions it reads from, the workers of the scheduler steal ready tasks from each other */
+	/* the tasks record into deferred command lists which are submitted in schedule order, null records everything on the calling thread */
+	void SetTaskScheduler(TaskScheduler* InScheduler)
+	{
+		Scheduler = InScheduler;
+	}
+
+	/* plans with fewer actions are recorded serially on the calling thread even with a scheduler, see ExecutePlan */
+	void SetMinParallelTasks(U32 InMinParallelTasks)
+	{
+		MinParallelTasks = InMinParallelTasks;
+	}
+
+	/* the culled actions in execution order for the current policy */
+	const std::vector<const IRenderPassAction*>& BuildSchedule(const std::vector<const IRenderPassAction*>& InAllActions);
+
+	/* the execution order of the last BuildSchedule or ScheduleGraphNodes */
+	const std::vector<const IRenderPassAction*>& GetSchedule() const
 	{
-		if (InAllActions.size() > 1)
-		{
-			std::vector<const IRenderPassAction*> AllActions;
-			AllActions.assign(InAllActions.begin(), InAllActions.end());
-			std::sort(AllActions.begin(), AllActions.end(), std::less<const IRenderPassAction*>());
-			ColorGraphNodesInternal(InAllActions.back(), AllActions);
-		}
+		return Schedule;
+	}
+
+	/* the culled actions in execution order compiled into a flat command list */
+	const ExecutionPlan& CompileExecutionPlan(const std::vector<const IRenderPassAction*>& InAllActions)
+	{
+		BuildSchedule(InAllActions);
+		CompileSchedule();
+		return Plan;
+	}
+
+	/* let actions that only write UAVs run on the async compute queue, the queues and fences are derived whenever a plan is compiled */
+	/* the policy can keep passes on the graphics queue that would only delay the work waiting for them */
+	void SetAsyncCompute(bool InAsyncCompute, QueueAssignment::AsyncComputePolicy InPolicy = nullptr)
+	{
+		AsyncCompute = InAsyncCompute;
+		AsyncComputePolicy = InPolicy;
+	}
+
+	/* start transitions right after the last use of a texture and end them before the action that needs the new state */
+	void SetSplitBarriers(bool InSplitBarriers)
+	{
+		Plan.SetSplitBarriers(InSplitBarriers);
+	}
+
+	/* the queues and fences of the last compiled plan, empty without async compute */
+	const QueueAssignment& GetQueueAssignment() const
+	{
+		return Queues;
 	}
 
 	void ScheduleGraphNodes(ImmediateRenderContext& RndCtx, const std::vector<const IRenderPassAction*>& InAllActions)
 	{
-		for (const IRenderPassAction* Action : InAllActions)
-		{
-			if (Action->GetColor() != UINT_MAX)
-			{
-				Action->Execute(RndCtx);
-			}
-		}
+		CompileExecutionPlan(InAllActions);
+		ExecutePlan(RndCtx);
 	}
 
 private:
-	bool ColorGraphNodesInternal(const IRenderPassAction* Action, std::vector<const IRenderPassAction*>& InAllActions);
+	/* one pending node of the depth first walk, mirrors the locals of a recursive visit */
+	struct ColorFrame
+	{
+		U32 Node;
+		U32 NextEdge;
+		U32 NumValidMutables;
+		U32 Child;
+		bool isFirstPath;
+	};
+
+	/* one resource an action touches, several entries of the same resource are merged */
+	struct ResourceAccess
+	{
+		U32 Resource;
+		bool IsWrite;
+	};
+
+	void BuildDependencies();
+	void BuildSchedulePredecessors();
+	void CompileSchedule();
+	void ExecutePlan(ImmediateRenderContext& RndCtx);
+	void BuildTaskDependencies();
+	void RunTaskWorker(U32 Worker);
+	void RunTask(U32 Task, U32 Worker);
+	void WakeTaskWorkers(bool All);
+	U32 PickReadyNode() const;
+	void LowerSchedulePeak();
+	U64 ComputeSchedulePeak(const std::vector<U32>& Nodes, U32& OutPeakPosition, U32& OutNumPeaks);
+
+	void BeginMaterialization();
+	bool IsLive(const ActionGraph::Edge& Edge) const;
+	void MarkLive(const ActionGraph::Edge& Edge);
+	/* the resources by dense id, of the compiled graph or the ones the builder recorded the keys with */
+	void MaterializeLiveResources(const std::vector<const TransientResourceBase*>& Resources);
+
+	void PushColorFrame(U32 Node);
+	void ColorGraphNodesInternal(U32 Root);
+
+	ActionGraph Graph;
+	/* nodes whose producers were fully processed, they are not walked again */
+	std::vector<bool> ProcessedNodes;
+	std::vector<ColorFrame> ColorStack;
+
+	/* the walk only works on a copy of the materialization bitfields by dense resource id */
+	/* MaterializeLiveResources writes them back in one sweep once coloring is done */
+	std::vector<bool> LiveResources;
+	std::vector<U32> LiveWordOffsets;
+	std::vector<U64> LiveSubResources;
+	/* resources the walk marked, in the order it marked them first, so they are materialized in the order the walk needed them */
+	std::vector<bool> MarkedResources;
+	std::vector<U32> MarkedOrder;
+
+	/* culling and scheduling result of a graph by record index */
+	struct CachedGraph
+	{
+		/* everything culling, scheduling and materialization depend on, see RenderPassBuilder::AddGraphKeys */
+		std::vector<U64> Keys;
+		std::vector<U32> Colors;
+		std::vector<U32> Schedule;
+		bool HasSchedule = false;
+
+		/* the state the culling walk materialized the resources with, by dense resource id */
+		std::vector<U32> MarkedOrder;
+		std::vector<U32> LiveWordOffsets;
+		std::vector<U64> LiveSubResources;
+	};
+
+	static constexpr size_t MaxCachedGraphs = 16;
+	U64 GetGraphCacheKey(const RenderPassBuilder& Builder) const;
+	std::unordered_map<U64, CachedGraph> GraphCache;
+	CachedGraph* CurrentGraph = nullptr;
+	U32 NumCacheHits = 0;
+
+	EGraphSchedulePolicy SchedulePolicy = EGraphSchedulePolicy::RecordedOrder;
+	std::vector<const IRenderPassAction*> Schedule;
+	ExecutionPlan Plan;
+	bool AsyncCompute = false;
+	QueueAssignment::AsyncComputePolicy AsyncComputePolicy;
+	QueueAssignment Queues;
+	TaskScheduler* Scheduler = nullptr;
+	static constexpr U32 DefaultMinParallelTasks = 128;
+	U32 MinParallelTasks = DefaultMinParallelTasks;
+
+	/* the scheduled actions as a task graph, successors are stored as a CSR by task index */
+	std::vector<U32> TaskSuccessorOffsets;
+	std::vector<U32> TaskSuccessors;
+	std::vector<U32> TaskPredecessorOffsets;
+	std::vector<U32> TaskPredecessors;
+	std::unique_ptr<std::atomic<U32>[]> PendingTaskPredecessors;
+	U32 TaskCapacity = 0;
+	std::atomic<U32> NumFinishedTasks{ 0 };
+	/* idle workers sleep until another worker pushed more tasks than it runs itself or the last task finished */
+	/* the epoch counts those wakeups, a worker that saw it change since its last look at the queues does not go to sleep */
+	std::mutex TaskMutex;
+	std::condition_variable TasksPushed;
+	std::atomic<U32> TaskEpoch{ 0 };
+	std::atomic<U32> NumSleepingWorkers{ 0 };
+	std::vector<std::unique_ptr<WorkStealingQueue>> TaskQueues;
+	/* one list per task, kept between frames so recording does not allocate once they grew */
+	std::vector<RenderCommandList> TaskCommandLists;
+	std::vector<U32> AccessOffsets;
+	std::vector<ResourceAccess> Accesses;
+	std::vector<U64> ResourceSizes;
+	std::vector<U32> RemainingAccesses;
+	std::vector<bool> AllocatedResources;
+	std::vector<U32> SuccessorOffsets;
+	std::vector<U32> Successors;
+	std::vector<U32> PendingPredecessors;
+	/* the node of every schedule position, only filled when the dependencies were built */
+	std::vector<U32> ScheduleNodes;
+	std::vector<U32> NodePositions;
+	std::vector<U32> SchedulePredecessorOffsets;
+	std::vector<U32> SchedulePredecessors;
+	std::vector<U32> PredecessorFillOffsets;
+	std::vector<U32> LatestPredecessor;
+	std::vector<U32> ReadyNodes;
+	/* first and last schedule position that touches a resource and the live bytes by position while LowerSchedulePeak tries a move */
+	std::vector<U32> FirstUses;
+	std::vector<U32> LastUses;
+	std::vector<I64> LiveBytes;
+	std::vector<U32> PeakCandidates;
+	std::vector<U32> TrialNodes;
+	std::vector<U32> BestNodes;
 
 	U32 CurrentColor = 1;
 	void NextColor()
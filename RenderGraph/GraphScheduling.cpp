@@ -0,0 +1,520 @@
+#include "GraphCulling.h"
+#include "Plumber.h"
+#include "Renderpass.h"
+#include <algorithm>
+#include <utility>
+
+const std::vector<const IRenderPassAction*>& GraphProcessor::BuildSchedule(const std::vector<const IRenderPassAction*>& InAllActions)
+{
+	Schedule.clear();
+	ScheduleNodes.clear();
+	if (SchedulePolicy == EGraphSchedulePolicy::RecordedOrder && !AsyncCompute)
+	{
+		for (const IRenderPassAction* Action : InAllActions)
+		{
+			if (Action->GetColor() != UINT_MAX)
+			{
+				Schedule.push_back(Action);
+			}
+		}
+		return Schedule;
+	}
+
+	//the queue assignment needs the dependencies even if the recorded order is kept
+	Graph.Compile(InAllActions);
+	BuildDependencies();
+	if (SchedulePolicy == EGraphSchedulePolicy::RecordedOrder)
+	{
+		for (U32 Node = 0; Node < Graph.GetNumNodes(); Node++)
+		{
+			if (Graph.GetAction(Node)->GetColor() != UINT_MAX)
+			{
+				Schedule.push_back(Graph.GetAction(Node));
+				ScheduleNodes.push_back(Node);
+			}
+		}
+		return Schedule;
+	}
+
+	const U32 NumNodes = Graph.GetNumNodes();
+	LatestPredecessor.assign(NumNodes, ActionGraph::InvalidNode);
+	AllocatedResources.assign(ResourceSizes.size(), false);
+	ReadyNodes.clear();
+	for (U32 Node = 0; Node < NumNodes; Node++)
+	{
+		if (Graph.GetAction(Node)->GetColor() != UINT_MAX && PendingPredecessors[Node] == 0)
+		{
+			ReadyNodes.push_back(Node);
+		}
+	}
+
+	while (!ReadyNodes.empty())
+	{
+		U32 ReadyIndex = PickReadyNode();
+		U32 Node = ReadyNodes[ReadyIndex];
+		ReadyNodes.erase(ReadyNodes.begin() + ReadyIndex);
+
+		U32 Position = U32(Schedule.size());
+		Schedule.push_back(Graph.GetAction(Node));
+		ScheduleNodes.push_back(Node);
+
+		for (U32 i = AccessOffsets[Node]; i < AccessOffsets[Node + 1]; i++)
+		{
+			AllocatedResources[Accesses[i].Resource] = true;
+			RemainingAccesses[Accesses[i].Resource]--;
+		}
+
+		for (U32 i = SuccessorOffsets[Node]; i < SuccessorOffsets[Node + 1]; i++)
+		{
+			U32 Successor = Successors[i];
+			LatestPredecessor[Successor] = Position;
+			if (--PendingPredecessors[Successor] == 0)
+			{
+				ReadyNodes.push_back(Successor);
+			}
+		}
+	}
+
+	//every live action has to be reachable, otherwise the dependencies had a cycle
+	check(Schedule.size() == (size_t)std::count_if(InAllActions.begin(), InAllActions.end(), [](const IRenderPassAction* Action) { return Action->GetColor() != UINT_MAX; }));
+
+	if (SchedulePolicy == EGraphSchedulePolicy::MinimizeMemory)
+	{
+		LowerSchedulePeak();
+	}
+	return Schedule;
+}
+
+/* the greedy pick cannot tell that a resource it starts now waits through a later peak, like a bokeh LUT built before the gather passes that only the scatter after them reads */
+/* so an action that starts a resource alive at the peak but not used there is moved right before its first successor */
+/* the move that lowers the peak the most, or leaves the fewest positions at the peak, is kept until no move helps anymore */
+void GraphProcessor::LowerSchedulePeak()
+{
+	const U32 NumTasks = U32(ScheduleNodes.size());
+	U32 PeakPosition = 0;
+	U32 NumPeaks = 0;
+	U64 Peak = ComputeSchedulePeak(ScheduleNodes, PeakPosition, NumPeaks);
+	while (Peak > 0)
+	{
+		NodePositions.assign(Graph.GetNumNodes(), ActionGraph::InvalidNode);
+		for (U32 Position = 0; Position < NumTasks; Position++)
+		{
+			NodePositions[ScheduleNodes[Position]] = Position;
+		}
+
+		//the first uses are overwritten by every trial, so the candidates are collected upfront
+		const U32 PeakNode = ScheduleNodes[PeakPosition];
+		PeakCandidates.clear();
+		for (U32 Resource = 0; Resource < ResourceSizes.size(); Resource++)
+		{
+			if (ResourceSizes[Resource] && FirstUses[Resource] < PeakPosition && LastUses[Resource] > PeakPosition
+				&& std::none_of(Accesses.begin() + AccessOffsets[PeakNode], Accesses.begin() + AccessOffsets[PeakNode + 1], [&](const ResourceAccess& Access) { return Access.Resource == Resource; }))
+			{
+				PeakCandidates.push_back(FirstUses[Resource]);
+			}
+		}
+
+		bool HasBestMove = false;
+		U64 BestPeak = Peak;
+		U32 BestNumPeaks = NumPeaks;
+		for (U32 Position : PeakCandidates)
+		{
+			const U32 Node = ScheduleNodes[Position];
+			U32 FirstSuccessor = NumTasks;
+			for (U32 i = SuccessorOffsets[Node]; i < SuccessorOffsets[Node + 1]; i++)
+			{
+				FirstSuccessor = std::min(FirstSuccessor, NodePositions[Successors[i]]);
+			}
+
+			//the action has to land behind the peak and stay in front of everything that waits for it
+			if (FirstSuccessor <= PeakPosition)
+				continue;
+
+			TrialNodes = ScheduleNodes;
+			std::rotate(TrialNodes.begin() + Position, TrialNodes.begin() + Position + 1, TrialNodes.begin() + FirstSuccessor);
+
+			U32 TrialPeakPosition = 0;
+			U32 TrialNumPeaks = 0;
+			const U64 TrialPeak = ComputeSchedulePeak(TrialNodes, TrialPeakPosition, TrialNumPeaks);
+			if (TrialPeak < BestPeak || (TrialPeak == BestPeak && TrialNumPeaks < BestNumPeaks))
+			{
+				HasBestMove = true;
+				BestPeak = TrialPeak;
+				BestNumPeaks = TrialNumPeaks;
+				BestNodes.swap(TrialNodes);
+			}
+		}
+
+		if (!HasBestMove)
+			break;
+
+		ScheduleNodes.swap(BestNodes);
+		Peak = ComputeSchedulePeak(ScheduleNodes, PeakPosition, NumPeaks);
+	}
+
+	for (U32 Position = 0; Position < NumTasks; Position++)
+	{
+		Schedule[Position] = Graph.GetAction(ScheduleNodes[Position]);
+	}
+}
+
+/* the transient bytes alive at every position of the order, counted like the TransientMemoryEstimator does, from the first to the last use of a resource */
+U64 GraphProcessor::ComputeSchedulePeak(const std::vector<U32>& Nodes, U32& OutPeakPosition, U32& OutNumPeaks)
+{
+	const U32 NumTasks = U32(Nodes.size());
+	FirstUses.assign(ResourceSizes.size(), ActionGraph::InvalidNode);
+	LastUses.assign(ResourceSizes.size(), ActionGraph::InvalidNode);
+	for (U32 Position = 0; Position < NumTasks; Position++)
+	{
+		const U32 Node = Nodes[Position];
+		for (U32 i = AccessOffsets[Node]; i < AccessOffsets[Node + 1]; i++)
+		{
+			const U32 Resource = Accesses[i].Resource;
+			if (FirstUses[Resource] == ActionGraph::InvalidNode)
+			{
+				FirstUses[Resource] = Position;
+			}
+			LastUses[Resource] = Position;
+		}
+	}
+
+	LiveBytes.assign(NumTasks + 1, 0);
+	for (U32 Resource = 0; Resource < ResourceSizes.size(); Resource++)
+	{
+		if (FirstUses[Resource] != ActionGraph::InvalidNode)
+		{
+			LiveBytes[FirstUses[Resource]] += I64(ResourceSizes[Resource]);
+			LiveBytes[LastUses[Resource] + 1] -= I64(ResourceSizes[Resource]);
+		}
+	}
+
+	I64 Bytes = 0;
+	I64 Peak = 0;
+	OutPeakPosition = 0;
+	OutNumPeaks = 0;
+	for (U32 Position = 0; Position < NumTasks; Position++)
+	{
+		Bytes += LiveBytes[Position];
+		if (Bytes > Peak)
+		{
+			Peak = Bytes;
+			OutPeakPosition = Position;
+			OutNumPeaks = 1;
+		}
+		else if (Bytes == Peak)
+		{
+			OutNumPeaks++;
+		}
+	}
+	return U64(Peak);
+}
+
+/* besides the producer edges an action that writes a resource has to wait for all earlier readers and writers of it */
+/* and a reader has to wait for the last writer, otherwise reordering would let a write overtake a read of the older revision */
+void GraphProcessor::BuildDependencies()
+{
+	const U32 NumNodes = Graph.GetNumNodes();
+	const U32 NumResources = Graph.GetNumResources();
+	AccessOffsets.clear();
+	Accesses.clear();
+	ResourceSizes.assign(NumResources, 0);
+	RemainingAccesses.assign(NumResources, 0);
+
+	std::vector<std::pair<U32, U32>> Dependencies;
+	std::vector<U32> LastWriters(NumResources, ActionGraph::InvalidNode);
+	std::vector<std::vector<U32>> Readers(NumResources);
+
+	auto AddDependency = [&](U32 From, U32 To)
+	{
+		if (From != ActionGraph::InvalidNode && From != To && Graph.GetAction(From)->GetColor() != UINT_MAX)
+		{
+			Dependencies.emplace_back(From, To);
+		}
+	};
+
+	for (U32 Node = 0; Node < NumNodes; Node++)
+	{
+		AccessOffsets.push_back(U32(Accesses.size()));
+		if (Graph.GetAction(Node)->GetColor() == UINT_MAX)
+			continue;
+
+		const U32 FirstAccess = U32(Accesses.size());
+		for (const ActionGraph::Edge& Input : Graph.GetEdges(Node))
+		{
+			AddDependency(Input.Producer, Node);
+
+			if (Input.Resource == ActionGraph::InvalidResource)
+				continue;
+
+			//only transient memory is accounted, external resources live for the whole frame anyway
+			const TransientResourceBase* Resource = Graph.GetResource(Input.Resource);
+			if (Input.Entry.IsMaterialized() && !Resource->IsExternalResource())
+			{
+				ResourceSizes[Input.Resource] = Resource->GetResourceByteSize();
+			}
+
+			auto Access = std::find_if(Accesses.begin() + FirstAccess, Accesses.end(), [&](const ResourceAccess& Other) { return Other.Resource == Input.Resource; });
+			if (Access == Accesses.end())
+			{
+				Accesses.push_back({ Input.Resource, Input.Entry.IsOutput() });
+				RemainingAccesses[Input.Resource]++;
+			}
+			else
+			{
+				Access->IsWrite |= Input.Entry.IsOutput();
+			}
+		}
+
+		for (U32 i = FirstAccess; i < Accesses.size(); i++)
+		{
+			const U32 Resource = Accesses[i].Resource;
+			AddDependency(LastWriters[Resource], Node);
+			if (Accesses[i].IsWrite)
+			{
+				for (U32 Reader : Readers[Resource])
+				{
+					AddDependency(Reader, Node);
+				}
+				Readers[Resource].clear();
+				LastWriters[Resource] = Node;
+			}
+			else
+			{
+				Readers[Resource].push_back(Node);
+			}
+		}
+	}
+	AccessOffsets.push_back(U32(Accesses.size()));
+
+	SuccessorOffsets.assign(NumNodes + 1, 0);
+	PendingPredecessors.assign(NumNodes, 0);
+	for (const std::pair<U32, U32>& Dependency : Dependencies)
+	{
+		SuccessorOffsets[Dependency.first + 1]++;
+		PendingPredecessors[Dependency.second]++;
+	}
+	for (U32 Node = 0; Node < NumNodes; Node++)
+	{
+		SuccessorOffsets[Node + 1] += SuccessorOffsets[Node];
+	}
+
+	Successors.resize(Dependencies.size());
+	std::vector<U32> FillOffsets(SuccessorOffsets.begin(), SuccessorOffsets.end() - 1);
+	for (const std::pair<U32, U32>& Dependency : Dependencies)
+	{
+		Successors[FillOffsets[Dependency.first]++] = Dependency.second;
+	}
+}
+
+/* index into ReadyNodes of the next action, ties go to the action that was recorded first */
+U32 GraphProcessor::PickReadyNode() const
+{
+	U32 BestIndex = 0;
+	I64 BestScore = 0;
+	for (U32 i = 0; i < ReadyNodes.size(); i++)
+	{
+		const U32 Node = ReadyNodes[i];
+		I64 Score = 0;
+		if (SchedulePolicy == EGraphSchedulePolicy::MinimizeMemory)
+		{
+			//bytes this action brings to life minus the bytes that die after it
+			for (U32 a = AccessOffsets[Node]; a < AccessOffsets[Node + 1]; a++)
+			{
+				const U32 Resource = Accesses[a].Resource;
+				if (!AllocatedResources[Resource])
+				{
+					Score += I64(ResourceSizes[Resource]);
+				}
+				if (RemainingAccesses[Resource] == 1)
+				{
+					Score -= I64(ResourceSizes[Resource]);
+				}
+			}
+
+			//only actions that free more than they allocate are pulled forward, the others keep the recorded order
+			//picking the smallest allocation instead starts branches early and raised the peak of the deferred renderer by 40%
+			if (Score > 0)
+			{
+				Score = 0;
+			}
+		}
+		else
+		{
+			Score = LatestPredecessor[Node] == ActionGraph::InvalidNode ? -1 : I64(LatestPredecessor[Node]);
+		}
+
+		if (i == 0 || Score < BestScore || (Score == BestScore && Node < ReadyNodes[BestIndex]))
+		{
+			BestIndex = i;
+			BestScore = Score;
+		}
+	}
+	return BestIndex;
+}
+
+U64 GraphProcessor::GetGraphCacheKey(const RenderPassBuilder& Builder) const
+{
+	return Builder.GetStructuralHash() * 1610612741 + U64(SchedulePolicy) * 31 + Builder.GetActionList().size();
+}
+
+void GraphProcessor::ColorGraphNodes(const RenderPassBuilder& Builder)
+{
+	const std::vector<const IRenderPassAction*>& AllActions = Builder.GetActionList();
+	if (AllActions.size() <= 1 || !Builder.IsRecordingGraphKeys())
+	{
+		//there is nothing to cull or nothing to find a cached result by
+		ColorGraphNodes(AllActions);
+		CurrentGraph = nullptr;
+		return;
+	}
+
+	//the keys were recorded along with the actions, before culling materialized anything
+	const std::vector<U64>& GraphKeys = Builder.GetGraphKeys();
+	auto Iter = GraphCache.find(GetGraphCacheKey(Builder));
+	if (Iter != GraphCache.end())
+	{
+		if (GraphKeys == Iter->second.Keys)
+		{
+			NumCacheHits++;
+			CurrentGraph = &Iter->second;
+			for (const IRenderPassAction* Action : AllActions)
+			{
+				Action->SetColor(CurrentGraph->Colors[Action->GetRecordIndex()]);
+			}
+
+			//the resources are new every frame, they get the subresources and the order the culling walk marked them with
+			MarkedOrder = CurrentGraph->MarkedOrder;
+			LiveWordOffsets = CurrentGraph->LiveWordOffsets;
+			LiveSubResources = CurrentGraph->LiveSubResources;
+			MaterializeLiveResources(Builder.GetGraphKeyResources());
+			return;
+		}
+	}
+
+	ColorGraphNodes(AllActions);
+
+	if (GraphCache.size() >= MaxCachedGraphs)
+	{
+		GraphCache.clear();
+	}
+
+	//a colliding hash replaces the older graph
+	CurrentGraph = &GraphCache[GetGraphCacheKey(Builder)];
+	*CurrentGraph = CachedGraph();
+	CurrentGraph->Keys = GraphKeys;
+	CurrentGraph->Colors.resize(AllActions.size());
+	for (const IRenderPassAction* Action : AllActions)
+	{
+		CurrentGraph->Colors[Action->GetRecordIndex()] = Action->GetColor();
+	}
+	CurrentGraph->MarkedOrder = MarkedOrder;
+	CurrentGraph->LiveWordOffsets = LiveWordOffsets;
+	CurrentGraph->LiveSubResources = LiveSubResources;
+}
+
+void GraphProcessor::ScheduleGraphNodes(ImmediateRenderContext& RndCtx, const RenderPassBuilder& Builder)
+{
+	const std::vector<const IRenderPassAction*>& AllActions = Builder.GetActionList();
+	if (CurrentGraph == nullptr)
+	{
+		ScheduleGraphNodes(RndCtx, AllActions);
+		return;
+	}
+
+	if (CurrentGraph->HasSchedule)
+	{
+		//the record indices of the actions of a builder are their nodes
+		Schedule.clear();
+		ScheduleNodes.clear();
+		for (U32 RecordIndex : CurrentGraph->Schedule)
+		{
+			Schedule.push_back(AllActions[RecordIndex]);
+			ScheduleNodes.push_back(RecordIndex);
+		}
+		//a cached schedule means the graph was not compiled for this frame, only the queue assignment needs it
+		if (AsyncCompute)
+		{
+			Graph.Compile(AllActions);
+			BuildDependencies();
+		}
+	}
+	else
+	{
+		BuildSchedule(AllActions);
+		CurrentGraph->Schedule.clear();
+		for (const IRenderPassAction* Action : Schedule)
+		{
+			CurrentGraph->Schedule.push_back(Action->GetRecordIndex());
+		}
+		CurrentGraph->HasSchedule = true;
+	}
+
+	CompileSchedule();
+	ExecutePlan(RndCtx);
+}
+
+void GraphProcessor::CompileSchedule()
+{
+	Plan.Compile(Schedule);
+	if (AsyncCompute)
+	{
+		BuildSchedulePredecessors();
+		Queues.Assign(Schedule, SchedulePredecessorOffsets, SchedulePredecessors, AsyncCompute, AsyncComputePolicy);
+	}
+	else
+	{
+		Queues.Reset();
+	}
+}
+
+
+/* the successors of BuildDependencies turned around into the predecessors of every schedule position */
+/* the positions are visited in order, so several edges between the same two actions are next to each other and listed once */
+void GraphProcessor::BuildSchedulePredecessors()
+{
+	const U32 NumTasks = U32(Schedule.size());
+	check(ScheduleNodes.size() == NumTasks);
+	NodePositions.assign(Graph.GetNumNodes(), ActionGraph::InvalidNode);
+	for (U32 Position = 0; Position < NumTasks; Position++)
+	{
+		NodePositions[ScheduleNodes[Position]] = Position;
+	}
+
+	SchedulePredecessorOffsets.assign(NumTasks + 1, 0);
+	PredecessorFillOffsets.assign(NumTasks, ActionGraph::InvalidNode);
+	for (U32 Position = 0; Position < NumTasks; Position++)
+	{
+		const U32 Node = ScheduleNodes[Position];
+		for (U32 i = SuccessorOffsets[Node]; i < SuccessorOffsets[Node + 1]; i++)
+		{
+			const U32 Successor = NodePositions[Successors[i]];
+			check(Successor > Position);
+			//the fill offsets remember the last predecessor until the offsets are known
+			if (PredecessorFillOffsets[Successor] != Position)
+			{
+				PredecessorFillOffsets[Successor] = Position;
+				SchedulePredecessorOffsets[Successor + 1]++;
+			}
+		}
+	}
+	for (U32 Position = 0; Position < NumTasks; Position++)
+	{
+		SchedulePredecessorOffsets[Position + 1] += SchedulePredecessorOffsets[Position];
+	}
+
+	SchedulePredecessors.resize(SchedulePredecessorOffsets[NumTasks]);
+	PredecessorFillOffsets.assign(SchedulePredecessorOffsets.begin(), SchedulePredecessorOffsets.end() - 1);
+	for (U32 Position = 0; Position < NumTasks; Position++)
+	{
+		const U32 Node = ScheduleNodes[Position];
+		for (U32 i = SuccessorOffsets[Node]; i < SuccessorOffsets[Node + 1]; i++)
+		{
+			const U32 Successor = NodePositions[Successors[i]];
+			U32& Fill = PredecessorFillOffsets[Successor];
+			if (Fill == SchedulePredecessorOffsets[Successor] || SchedulePredecessors[Fill - 1] != Position)
+			{
+				SchedulePredecessors[Fill++] = Position;
+			}
+		}
+	}
+}
\ No newline at end of file
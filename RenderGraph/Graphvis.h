@@ -134,8 +134,8 @@ struct PinStyle
 	void DebugPrint(FILE* fhp) const
 	{
 		fprintf(fhp, 
-			R"(//EntryInfoName: %s Immaginary: 0x%I64X Owner: %s Parent: %s)", 
-			Entry.GetName(), (UintPtr)Entry.GetImaginaryResource(), Entry.GetOwner()->GetName(), Entry.GetParent() ? Entry.GetParent()->GetName() : "Orphan");
+			R"(//EntryInfoName: %s Immaginary: 0x%llX Owner: %s Parent: %s)", 
+			Entry.GetName(), (unsigned long long)(UintPtr)Entry.GetImaginaryResource(), Entry.GetOwner()->GetName(), Entry.GetParent() ? Entry.GetParent()->GetName() : "Orphan");
 	}
 
 	void DrawArrow(FILE* fhp) const
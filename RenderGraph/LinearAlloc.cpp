@@ -1,82 +1,288 @@
 #include "LinearAlloc.h"
 #include "Assert.h"
+#ifdef _MSC_VER
 #include <malloc.h>
-
-
-#define USE_ATOMICS 0
-#if USE_ATOMICS
-#include <atomic>
+#else
+#include <mm_malloc.h>
 #endif
+#include <atomic>
+#include <mutex>
+#include <vector>
 
+/* a chain of large blocks, when a block is exhausted the next one is used or a new one is appended */
+/* blocks are kept on reset so a steady state frame does not touch the heap at all */
 struct SimpleLinearAllocator
 {
-	SimpleLinearAllocator(U64 InSize, U64 InAlignment = 8) : Offset(0), Size(InSize), Alignment(InAlignment)
-	{
-		Base = reinterpret_cast<U8*>(_mm_malloc(Size, Alignment));
-	}
+	static const U64 DefaultBlockSize = 4 * 1024 * 1024;
+
+	SimpleLinearAllocator(U64 InBlockSize = DefaultBlockSize, U64 InAlignment = 8) : BlockSize(InBlockSize), Alignment(InAlignment)
+	{}
 
 	~SimpleLinearAllocator()
 	{
-		_mm_free(Base);
+		for (const Block& B : Blocks)
+		{
+			_mm_free(B.Base);
+		}
 	}
 
 	void* Alloc(U64 InSize)
 	{
 		U64 AllocSize = RoundUp(InSize, Alignment);
-#if USE_ATOMICS
-		U64 AllocOffset = Offset.fetch_add(AllocSize);
-#else
+		if (CurrentBlock == Blocks.size() || Offset + AllocSize > Blocks[CurrentBlock].Size)
+		{
+			NextBlock(AllocSize);
+		}
+
 		U64 AllocOffset = Offset;
 		Offset += AllocSize;
-#endif
-		check(AllocOffset + AllocSize < Size);
-		return Base + AllocOffset;
+		UsedBytes += AllocSize;
+		HighWaterMark = UsedBytes > HighWaterMark ? UsedBytes : HighWaterMark;
+		return Blocks[CurrentBlock].Base + AllocOffset;
 	}
 
 	void Reset()
 	{
-		memset(Base, 0xCD, Size);
+#if _DEBUG
+		for (size_t i = 0; i < Blocks.size() && i <= CurrentBlock; i++)
+		{
+			memset(Blocks[i].Base, 0xCD, Blocks[i].Size);
+		}
+#endif
+		CurrentBlock = 0;
 		Offset = 0;
+		UsedBytes = 0;
 	}
 
 	bool Contains(const void* Ptr)
 	{
-		if (Ptr < Base)
-			return false;
-		if (Ptr >= (Base + Size))
-			return false;
+		for (const Block& B : Blocks)
+		{
+			if (Ptr >= B.Base && Ptr < (B.Base + B.Size))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
 
-		return true;
+	void AccumulateStats(LinearAllocStats& Stats) const
+	{
+		Stats.UsedBytes += UsedBytes;
+		Stats.HighWaterMark += HighWaterMark;
+		Stats.NumBlocks += U32(Blocks.size());
+		for (const Block& B : Blocks)
+		{
+			Stats.ReservedBytes += B.Size;
+		}
 	}
 
 private:
+	struct Block
+	{
+		U8* Base;
+		U64 Size;
+	};
+
+	/* move on to the next block that can hold the allocation, oversized allocations get a dedicated block */
+	void NextBlock(U64 AllocSize)
+	{
+		if (CurrentBlock < Blocks.size())
+		{
+			CurrentBlock++;
+		}
+
+		while (CurrentBlock < Blocks.size() && Blocks[CurrentBlock].Size < AllocSize)
+		{
+			CurrentBlock++;
+		}
+
+		if (CurrentBlock == Blocks.size())
+		{
+			U64 NewBlockSize = AllocSize > BlockSize ? AllocSize : BlockSize;
+			U8* NewBase = reinterpret_cast<U8*>(_mm_malloc(NewBlockSize, Alignment));
+			check(NewBase != nullptr);
+			Blocks.push_back({ NewBase, NewBlockSize });
+		}
+		Offset = 0;
+	}
+
 	inline static U64 RoundUp(U64 size, U64 align)
 	{
 		return (size + align - 1) & ~(align - 1);
 	}
 
-	U8* Base; 
-#if USE_ATOMICS
-	std::atomic<U64> Offset;
-#else
-	U64 Offset;
-#endif
-	const U64 Size;
+	std::vector<Block> Blocks;
+	size_t CurrentBlock = 0;
+	U64 Offset = 0;
+	U64 UsedBytes = 0;
+	U64 HighWaterMark = 0;
+	const U64 BlockSize;
 	const U64 Alignment;
 };
 
-static SimpleLinearAllocator* LinearAllocator = new SimpleLinearAllocator(32 * 1024 * 1024);
+/* the slot of the frame that is currently being built, all older slots may still be in flight */
+static std::atomic<U32> CurrentFrameSlot(0);
+
+/* a ring of arenas with one region per frame in flight, so a frame can be built while the previous ones are still executing */
+struct FrameRingAllocator
+{
+	void* Alloc(U64 InSize)
+	{
+		return Frames[CurrentFrameSlot.load(std::memory_order_relaxed)].Alloc(InSize);
+	}
+
+	void Reset(U32 FrameSlot)
+	{
+		Frames[FrameSlot].Reset();
+	}
+
+	bool Contains(const void* Ptr)
+	{
+		for (SimpleLinearAllocator& Frame : Frames)
+		{
+			if (Frame.Contains(Ptr))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/* the high water mark of a ring is the largest peak of any of its frames */
+	void AccumulateStats(LinearAllocStats& Stats) const
+	{
+		U64 FrameHighWaterMark = 0;
+		for (const SimpleLinearAllocator& Frame : Frames)
+		{
+			LinearAllocStats FrameStats;
+			Frame.AccumulateStats(FrameStats);
+			Stats.UsedBytes += FrameStats.UsedBytes;
+			Stats.ReservedBytes += FrameStats.ReservedBytes;
+			Stats.NumBlocks += FrameStats.NumBlocks;
+			FrameHighWaterMark = FrameStats.HighWaterMark > FrameHighWaterMark ? FrameStats.HighWaterMark : FrameHighWaterMark;
+		}
+		Stats.HighWaterMark += FrameHighWaterMark;
+	}
+
+private:
+	SimpleLinearAllocator Frames[NUM_LINEAR_ALLOC_FRAMES];
+};
+
+/* owns every arena that was ever handed to a thread, arenas of exited threads are recycled but keep their memory until the next reset */
+struct LinearAllocatorRegistry
+{
+	FrameRingAllocator* Acquire()
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		if (!FreeArenas.empty())
+		{
+			FrameRingAllocator* Arena = FreeArenas.back();
+			FreeArenas.pop_back();
+			return Arena;
+		}
+
+		FrameRingAllocator* Arena = new FrameRingAllocator();
+		AllArenas.push_back(Arena);
+		return Arena;
+	}
+
+	void Release(FrameRingAllocator* Arena)
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		FreeArenas.push_back(Arena);
+	}
+
+	/* advance to the next frame and recycle its region which was last used NUM_LINEAR_ALLOC_FRAMES frames ago */
+	void NextFrame()
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		U32 FrameSlot = (CurrentFrameSlot.load(std::memory_order_relaxed) + 1) % NUM_LINEAR_ALLOC_FRAMES;
+		for (FrameRingAllocator* Arena : AllArenas)
+		{
+			Arena->Reset(FrameSlot);
+		}
+		CurrentFrameSlot.store(FrameSlot, std::memory_order_release);
+	}
+
+	bool Contains(const void* Ptr)
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		for (FrameRingAllocator* Arena : AllArenas)
+		{
+			if (Arena->Contains(Ptr))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	LinearAllocStats GetStats()
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		LinearAllocStats Stats;
+		for (FrameRingAllocator* Arena : AllArenas)
+		{
+			Stats.NumArenas++;
+			Arena->AccumulateStats(Stats);
+		}
+		return Stats;
+	}
+
+private:
+	std::mutex Mutex;
+	std::vector<FrameRingAllocator*> AllArenas;
+	std::vector<FrameRingAllocator*> FreeArenas;
+};
+
+static LinearAllocatorRegistry& GetLinearAllocatorRegistry()
+{
+	static LinearAllocatorRegistry* Registry = new LinearAllocatorRegistry();
+	return *Registry;
+}
+
+/* the arena is only acquired on the first allocation so threads that never build a graph do not cost any memory */
+struct ThreadLinearAllocator
+{
+	~ThreadLinearAllocator()
+	{
+		if (Arena != nullptr)
+		{
+			GetLinearAllocatorRegistry().Release(Arena);
+		}
+	}
+
+	FrameRingAllocator& Get()
+	{
+		if (Arena == nullptr)
+		{
+			Arena = GetLinearAllocatorRegistry().Acquire();
+		}
+		return *Arena;
+	}
+
+private:
+	FrameRingAllocator* Arena = nullptr;
+};
+
+static thread_local ThreadLinearAllocator LinearAllocator;
 void* LinearAlloc(U64 InSize)
 {
-	return LinearAllocator->Alloc(InSize);
+	return LinearAllocator.Get().Alloc(InSize);
 }
 
 void LinearReset()
 {
-	 LinearAllocator->Reset();
+	GetLinearAllocatorRegistry().NextFrame();
 }
 
 bool AllocContains(const void* Ptr)
 {
-	return LinearAllocator->Contains(Ptr);
+	return GetLinearAllocatorRegistry().Contains(Ptr);
+}
+
+LinearAllocStats LinearAllocGetStats()
+{
+	return GetLinearAllocatorRegistry().GetStats();
 }
\ No newline at end of file
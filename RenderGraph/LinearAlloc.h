@@ -2,6 +2,10 @@
 #include "Types.h"
 #include <utility>
 
+/* the number of frames that can be built or executed at the same time before their memory gets recycled */
+static const U32 NUM_LINEAR_ALLOC_FRAMES = 3;
+
+/* every thread allocates from its own arena so graphs can be built in parallel without any locking */
 void* LinearAlloc(U64 InSize);
 
 bool AllocContains(const void* Ptr);
@@ -25,4 +29,18 @@ inline T* LinearNew(ARGS&&... Args)
 	return new (LinearAlloc(sizeof(T))) T(std::forward<ARGS>(Args)...);
 }
 
+/* memory usage summed over the arenas of all threads, the high water mark is the sum of the per arena peaks */
+struct LinearAllocStats
+{
+	U64 UsedBytes = 0;
+	U64 HighWaterMark = 0;
+	U64 ReservedBytes = 0;
+	U32 NumBlocks = 0;
+	U32 NumArenas = 0;
+};
+
+LinearAllocStats LinearAllocGetStats();
+
+/* starts a new frame for the arenas of all threads, only the region of the frame NUM_LINEAR_ALLOC_FRAMES frames ago is recycled */
+/* so it is safe to call while older frames are still executing, as long as no thread is currently building a graph and that oldest frame has retired */
 void LinearReset();
\ No newline at end of file
@@ -1,10 +1,11 @@
 #include <iostream>
 #include <cstdio>
-#include <chrono>
 #include <stdlib.h>
 
 #include "Plumber.h"
 #include "GraphCulling.h"
+#include "MemoryEstimator.h"
+#include "QueueAssignment.h"
 #include "Graphvis.h"
 #include "Renderpass.h"
 #include "DeferredRenderingPass.h"
@@ -12,14 +13,10 @@
 #include "LinearAlloc.h"
 #include "DownSamplePass.h"
 #include "PostprocessingPass.h"
+#include "TaskScheduler.h"
 
-int ItterationCount = 1000;
-
-namespace RDAG
-{
-	SIMPLE_TEX_HANDLE(SimpleResourceHandle);
-}
-
+/* builds, culls and executes the example deferred renderer once and prints what the graph needs, timings are measured by Benchmark/Benchmark.cpp */
+/* usage: RenderGraph [DotFile], with a file the graph is also written as graphviz dot (test.bat renders ../test.dot) */
 int main(int argc, char* argv[])
 {	
 	SceneViewInfo ViewInfo;
@@ -36,18 +33,8 @@ int main(int argc, char* argv[])
 	//ViewInfo.DofSettings.EnablePostfilterMethod = false;
 	ViewInfo.DofSettings.RecombineQuality = 0;
 
-	{
-		const char* Key = "MainTemporalAA";
-		U64 Size = strlen(Key) + 1;
-		ViewInfo.MainTemporalAAKey = new char[Size];
-		strcpy(ViewInfo.MainTemporalAAKey, Key);
-	}
-	{
-		const char* Key = "DofTemporalAA";
-		U64 Size = strlen(Key) + 1;
-		ViewInfo.DoFTemporalAAKey = new char[Size];
-		strcpy(ViewInfo.DoFTemporalAAKey, Key);
-	}
+	ViewInfo.MainTemporalAAKey = InternedStrings::Intern("MainTemporalAA");
+	ViewInfo.DoFTemporalAAKey = InternedStrings::Intern("DofTemporalAA");
 
 	if (argc > 200)
 	{
@@ -60,103 +47,61 @@ int main(int argc, char* argv[])
 		}
 	}
 
+	TaskScheduler Scheduler;
 	RenderPassBuilder Builder;
+	Builder.SetDeduplicateActions(true);
+	Builder.SetTaskScheduler(&Scheduler);
 
 	{
-		std::chrono::duration<long long, std::nano> minDuration(std::numeric_limits<long long>::max());
-		for (int i = 0; i < ItterationCount; i++)
-		{
-			LinearReset();
-
-			auto start = std::chrono::high_resolution_clock::now();
-
-			using PassInputType = ResourceTable<>;
-			using PassOutputType = ResourceTable<RDAG::SimpleResourceHandle>;
-			auto SimpleRenderPass = [](const RenderPassBuilder& Builder, const PassInputType& Input) -> PassOutputType
-			{
-				Texture2d::Descriptor TargetDescriptor;
-				TargetDescriptor.Name = "RenderTarget";
-				TargetDescriptor.Format = ERenderResourceFormat::ARGB8U;
-				TargetDescriptor.Height = 32;
-				TargetDescriptor.Width = 32;
-				TargetDescriptor.ComputeFullMipChain();
-
-				return Seq
-				{
-					Builder.CreateResource<RDAG::SimpleResourceHandle>( TargetDescriptor ),
-					Builder.QueueRenderAction("SimpleRenderAction", [](RenderContext& Ctx, const PassOutputType&)
-					{
-						Ctx.Draw("SimpleRenderAction");
-					})
-				}(Input);
-			};
-
-			auto val = Seq
-			{
-				Builder.BuildRenderPass("SimpleRenderPass", SimpleRenderPass),
-				Builder.AssignEntry<RDAG::SimpleResourceHandle, RDAG::DownsampleInput>(),
-				Builder.BuildRenderPass("PyramidDownSampleRenderPass", PyramidDownSampleRenderPass::Build),
-				Builder.AssignEntry<RDAG::DownsamplePyramid, RDAG::PostProcessingInput>(2),
-				Builder.BuildRenderPass("ToneMappingPass", ToneMappingPass::Build)
-			}(ResourceTable<>());
-			(void)val;
-
-
-			auto time = std::chrono::high_resolution_clock::now() - start;
-			minDuration = std::min(minDuration, time);
-		}
-		std::cout << "simple build time: " << (std::chrono::duration_cast<std::chrono::microseconds>(minDuration).count()) << "us\n";
-	}
+		LinearReset();
 
-	{
-		std::chrono::duration<long long, std::nano> minDuration(std::numeric_limits<long long>::max());
-		//minDuration = std::numeric_limits<decltype(minDuration)>::max();
-		for (int i = 0; i < ItterationCount; i++)
+		auto val = Seq
 		{
-			LinearReset();
+			Builder.BuildRenderPass("MainRenderPass", DeferredRendererPass::Build, ViewInfo)
+		}(ResourceTable<>());
+		(void)val;
 
-			auto start = std::chrono::high_resolution_clock::now();
+		std::cout << "recorded actions: " << Builder.GetActionList().size() << ", " << Builder.GetNumDeduplicatedActions() << " duplicate actions removed\n";
 
-			Builder.Reset();
+		LinearAllocStats AllocStats = LinearAllocGetStats();
+		std::cout << "linear alloc high water mark: " << AllocStats.HighWaterMark / 1024 << "kb in " << AllocStats.NumBlocks << " blocks\n";
+	}
 
-			auto val = Seq
-			{
-				Builder.BuildRenderPass("MainRenderPass", DeferredRendererPass::Build, ViewInfo)
-			}(ResourceTable<>());
-			(void)val;
+	GraphProcessor GPU;
+	GPU.ColorGraphNodes(Builder.GetActionList());
 
-			auto time = std::chrono::high_resolution_clock::now() - start;
-			minDuration = std::min(minDuration, time);
-		}
-		std::cout << "build time: " << (std::chrono::duration_cast<std::chrono::microseconds>(minDuration).count()) << "us\n";
-	}
-	
 	{
-		auto start = std::chrono::high_resolution_clock::now();
-
-		for (int i = 0; i < ItterationCount; i++)
+		TransientMemoryEstimator Estimator;
+		Estimator.SetBudget(256ull * 1024 * 1024, [](const TransientMemoryEstimator& Estimate)
 		{
-			GraphProcessor GPU;
-			GPU.ColorGraphNodes(Builder.GetActionList());
-		}
-
-		auto time = std::chrono::high_resolution_clock::now() - start;
-		std::cout << "optimizer time: " << std::chrono::duration_cast<std::chrono::microseconds>(time).count() / (double)ItterationCount << "us\n";
+			std::cout << "transient memory budget exceeded: " << Estimate.GetAliasedBytes() / 1024 << "kb of " << Estimate.GetBudgetBytes() / 1024 << "kb\n";
+		});
+		Estimator.Estimate(GPU.BuildSchedule(Builder.GetActionList()));
+		std::cout << "aliased peak: " << Estimator.GetAliasedBytes() / 1024 << "kb live peak: " << Estimator.GetPeakBytes() / 1024 << "kb naive peak: " << Estimator.GetTotalBytes() / 1024 << "kb\n";
 	}
 
+	if (argc > 1)
 	{
-		GraphvisNeoWriter Writer("../test.dot", Builder.GetActionList());
+		GraphvisNeoWriter Writer(argv[1], Builder.GetActionList());
 	}
 
-	std::cin.get();
-
 	{
-		GraphProcessor GPU;
+		GPU.SetTaskScheduler(&Scheduler);
+		GPU.SetAsyncCompute(true);
+		GPU.SetSplitBarriers(true);
 		ImmediateRenderContext RndCtx;
 		GPU.ScheduleGraphNodes(RndCtx, Builder.GetActionList());
-	}
 
-	std::cin.get();
+		MultiQueueSimulator Simulator;
+		Simulator.Simulate(GPU.GetQueueAssignment());
+		Simulator.Print();
+
+		const BarrierStats& Barriers = RndCtx.GetBarrierStats();
+		std::cout << "resource barriers: " << Barriers.NumTransitions << " transitions in " << Barriers.NumBatches << " batches, largest batch: " << Barriers.LargestBatch << ", split: " << Barriers.NumSplitTransitions << "\n";
+
+		TransientResourcePool<Texture2d>::Get().NextFrame();
+		ExternalResourceRegistry<Texture2d>::Get().NextFrame();
+	}
 
 	return 0;
 }
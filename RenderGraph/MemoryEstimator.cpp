@@ -0,0 +1,60 @@
+#include "MemoryEstimator.h"
+#include "Assert.h"
+#include <stdio.h>
+
+bool TransientMemoryEstimator::Estimate(const std::vector<const IRenderPassAction*>& InAllActions)
+{
+	ActionUsage.clear();
+	PeakBytes = 0;
+
+	for (const IRenderPassAction* Action : InAllActions)
+	{
+		if (Action->GetColor() != UINT_MAX)
+		{
+			ActionMemoryUsage Usage;
+			Usage.Action = Action;
+			ActionUsage.push_back(Usage);
+		}
+	}
+
+	//the plan uses the same execution indices as the culled action list above
+	AliasingPlan.Compile(InAllActions);
+	for (const AliasedResource& Resource : AliasingPlan.GetResources())
+	{
+		ActionUsage[Resource.FirstUse].AllocatedBytes += Resource.Size;
+		for (U32 i = Resource.FirstUse; i <= Resource.LastUse; i++)
+		{
+			ActionUsage[i].LiveBytes += Resource.Size;
+		}
+	}
+
+	for (const ActionMemoryUsage& Usage : ActionUsage)
+	{
+		PeakBytes = Usage.LiveBytes > PeakBytes ? Usage.LiveBytes : PeakBytes;
+	}
+
+	if (!IsWithinBudget())
+	{
+		if (Hook)
+		{
+			Hook(*this);
+		}
+		else
+		{
+			check(false);
+		}
+		return false;
+	}
+	return true;
+}
+
+void TransientMemoryEstimator::Print() const
+{
+	for (const ActionMemoryUsage& Usage : ActionUsage)
+	{
+		printf("ActionMemory: %s Live: %llukb Allocated: %llukb \n", Usage.Action->GetName(), 
+			(unsigned long long)(Usage.LiveBytes / 1024), (unsigned long long)(Usage.AllocatedBytes / 1024));
+	}
+	printf("Transient memory peak: %llukb total: %llukb aliased: %llukb budget: %llukb \n", (unsigned long long)(PeakBytes / 1024), 
+		(unsigned long long)(GetTotalBytes() / 1024), (unsigned long long)(GetAliasedBytes() / 1024), (unsigned long long)(BudgetBytes / 1024));
+}
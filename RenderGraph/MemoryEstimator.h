@@ -0,0 +1,77 @@
+#pragma once
+#include "Renderpass.h"
+#include "ResourceAliasing.h"
+#include "Types.h"
+#include <functional>
+#include <vector>
+
+/* the transient memory situation while a single culled action executes */
+struct ActionMemoryUsage
+{
+	const IRenderPassAction* Action = nullptr;
+	/* bytes of all transient resources that are alive during this action */
+	U64 LiveBytes = 0;
+	/* bytes of the transient resources that are first used by this action */
+	U64 AllocatedBytes = 0;
+};
+
+/* estimates the transient memory of a culled graph before it is executed */
+/* with a budget set the estimate fails when the peak is over the limit, so different SceneViewInfo configurations can be validated upfront */
+class TransientMemoryEstimator
+{
+public:
+	using BudgetExceededHook = std::function<void(const TransientMemoryEstimator&)>;
+
+	/* a budget of 0 disables the budget check, without a hook exceeding the budget fails with check */
+	void SetBudget(U64 InBudgetBytes, BudgetExceededHook InHook = nullptr)
+	{
+		BudgetBytes = InBudgetBytes;
+		Hook = InHook;
+	}
+
+	/* takes the actions in execution order (e.g. GraphProcessor::BuildSchedule), culled actions are skipped */
+	/* needs to run after the GraphProcessor colored the graph, returns false if the budget is exceeded */
+	bool Estimate(const std::vector<const IRenderPassAction*>& InAllActions);
+
+	const std::vector<ActionMemoryUsage>& GetActionUsage() const
+	{
+		return ActionUsage;
+	}
+
+	/* the highest amount of memory alive at the same time (without aliasing restrictions) */
+	U64 GetPeakBytes() const
+	{
+		return PeakBytes;
+	}
+
+	/* the memory needed if every transient resource got its own allocation */
+	U64 GetTotalBytes() const
+	{
+		return AliasingPlan.GetNaivePeak();
+	}
+
+	/* the heap size after aliasing the resources with the ResourceAliasingPlan */
+	U64 GetAliasedBytes() const
+	{
+		return AliasingPlan.GetAliasedPeak();
+	}
+
+	U64 GetBudgetBytes() const
+	{
+		return BudgetBytes;
+	}
+
+	bool IsWithinBudget() const
+	{
+		return BudgetBytes == 0 || GetAliasedBytes() <= BudgetBytes;
+	}
+
+	void Print() const;
+
+private:
+	ResourceAliasingPlan AliasingPlan;
+	std::vector<ActionMemoryUsage> ActionUsage;
+	U64 PeakBytes = 0;
+	U64 BudgetBytes = 0;
+	BudgetExceededHook Hook;
+};
@@ -33,36 +33,63 @@ public:
 	bool IsDiscardedResource() const { return ResourceFlags == EResourceFlags::Discard; };
 	bool IsManagedResource() const { return All(EResourceFlags::Managed, ResourceFlags); };
 	bool IsExternalResource() const { return All(EResourceFlags::External, ResourceFlags); };
+	EResourceFlags::Type GetResourceFlags() const { return ResourceFlags; };
 };
 
+template<typename TransientType>
+class TransientResource;
+
 /* Transient ResourceBase */
 class TransientResourceBase
 {
 private:
+	/* up to 64 subresources are tracked inline, only bigger resources need an extra allocation for the bitfield */
+	union SubResourceBitField
+	{
+		U64 Inline;
+		U64* Heap;
+	};
+
 	/* The type can be recovered by the TransientResourceImpl */
 	mutable MaterializedResource* Resource = nullptr;
-	mutable U64* MaterializedSubResources = nullptr;
+	mutable SubResourceBitField MaterializedSubResources;
 	U32 SubResourceCount = 0;
 	U32 BitFieldIntegers = 0;
 	static const U64 BitsPerInt = sizeof(U64) * 8;
 
+	friend struct ActionGraph;
+	friend struct RenderPassBuilder;
+	/* dense id of the last graph compiled or recorded with this resource, only trusted while that graph maps the id back to this resource */
+	mutable U32 GraphIndex = ~0u;
+	/* reader list of the lazy renderpasses filed under this resource, only trusted while the builder maps the list back to this resource */
+	mutable U32 LazyReaderList = ~0u;
+
+	bool IsInlineBitField() const
+	{
+		return SubResourceCount <= BitsPerInt;
+	}
+
 protected:
 	TransientResourceBase(U32 InSubResourceCount) : SubResourceCount(InSubResourceCount)
 	{
 		BitFieldIntegers = (SubResourceCount + BitsPerInt - 1) / BitsPerInt;
-		MaterializedSubResources = LinearAlloc<U64>(BitFieldIntegers);
 
-		for (U32 i = 0; i < BitFieldIntegers; i++)
+		/* the unused bits are set upfront, so checking all subresources is a compare against ~0 per integer */
+		U64 Remainder = (BitFieldIntegers * BitsPerInt) - SubResourceCount;
+		U64 FillValue = Remainder != 0 ? (~0ull << (BitsPerInt - Remainder)) : 0ull;
+
+		if (IsInlineBitField())
 		{
-			MaterializedSubResources[i] = 0ull;
+			MaterializedSubResources.Inline = SubResourceCount != 0 ? FillValue : ~0ull;
 		}
-
-		U64 Remainder = (BitFieldIntegers * BitsPerInt) - SubResourceCount;
-		if (Remainder != 0)
+		else
 		{
-			U64 FillValue = ~0ull;
-			FillValue <<= BitsPerInt - Remainder;
-			MaterializedSubResources[BitFieldIntegers - 1] = FillValue;
+			MaterializedSubResources.Heap = LinearAlloc<U64>(BitFieldIntegers);
+			for (U32 i = 0; i < BitFieldIntegers; i++)
+			{
+				MaterializedSubResources.Heap[i] = 0ull;
+			}
+			MaterializedSubResources.Heap[BitFieldIntegers - 1] |= FillValue;
 		}
 	}
 
@@ -75,45 +102,64 @@ public:
 			Resource = MaterializeInternal();
 		}
 
-		if (SubResourceIndex == ALL_SUBRESOURCE_INDICIES)
+		if (IsInlineBitField())
+		{
+			if (SubResourceIndex == ALL_SUBRESOURCE_INDICIES)
+			{
+				MaterializedSubResources.Inline = ~0ull;
+			}
+			else
+			{
+				check(SubResourceIndex < SubResourceCount);
+				MaterializedSubResources.Inline |= 1ull << SubResourceIndex;
+			}
+		}
+		else if (SubResourceIndex == ALL_SUBRESOURCE_INDICIES)
 		{
 			for (U32 i = 0; i < BitFieldIntegers; i++)
 			{
-				MaterializedSubResources[i] = ~0ull;
+				MaterializedSubResources.Heap[i] = ~0ull;
 			}
 		}
 		else
 		{
 			check(SubResourceIndex < SubResourceCount);
-			MaterializedSubResources[SubResourceIndex / BitsPerInt] |= 1ull << (SubResourceIndex % BitsPerInt);
+			MaterializedSubResources.Heap[SubResourceIndex / BitsPerInt] |= 1ull << (SubResourceIndex % BitsPerInt);
 		}
 	}
 
 	bool IsMaterialized(U32 SubResourceIndex) const 
 	{ 
-		if (Resource != nullptr)
+		if (Resource == nullptr)
+		{
+			return false;
+		}
+
+		if (IsInlineBitField())
 		{
 			if (SubResourceIndex == ALL_SUBRESOURCE_INDICIES)
 			{
-				for (U32 i = 0; i < BitFieldIntegers; i++)
-				{
-					if (MaterializedSubResources[i] != ~0ull)
-					{
-						return false;
-					}
-				}
-				return true;
+				return MaterializedSubResources.Inline == ~0ull;
 			}
-			else
+			check(SubResourceIndex < SubResourceCount);
+			return (MaterializedSubResources.Inline >> SubResourceIndex) & 1ull;
+		}
+		else if (SubResourceIndex == ALL_SUBRESOURCE_INDICIES)
+		{
+			for (U32 i = 0; i < BitFieldIntegers; i++)
 			{
-				check(SubResourceIndex < SubResourceCount);
-				if ((MaterializedSubResources[SubResourceIndex / BitsPerInt] >> (SubResourceIndex % BitsPerInt)) & 1ull)
+				if (MaterializedSubResources.Heap[i] != ~0ull)
 				{
-					return true;
+					return false;
 				}
 			}
+			return true;
+		}
+		else
+		{
+			check(SubResourceIndex < SubResourceCount);
+			return (MaterializedSubResources.Heap[SubResourceIndex / BitsPerInt] >> (SubResourceIndex % BitsPerInt)) & 1ull;
 		}
-		return false;
 	}
 
 	bool IsExternalResource() const 
@@ -121,6 +167,38 @@ public:
 		return Resource && Resource->IsExternalResource(); 
 	}
 
+	/* the bitfield has the same layout inline or on the heap: subresource i is bit i % 64 of word i / 64 */
+	U32 GetNumSubResourceWords() const
+	{
+		return IsInlineBitField() ? 1 : BitFieldIntegers;
+	}
+
+	/* copies the bitfield into OutWords, returns false as long as the resource was never materialized */
+	bool GetMaterializedSubResources(U64* OutWords) const
+	{
+		const U64* Words = IsInlineBitField() ? &MaterializedSubResources.Inline : MaterializedSubResources.Heap;
+		for (U32 i = 0; i < GetNumSubResourceWords(); i++)
+		{
+			OutWords[i] = Words[i];
+		}
+		return Resource != nullptr;
+	}
+
+	/* materializes every subresource that is set in the words at once */
+	void MaterializeSubResources(const U64* InWords) const
+	{
+		if (Resource == nullptr)
+		{
+			Resource = MaterializeInternal();
+		}
+
+		U64* Words = IsInlineBitField() ? &MaterializedSubResources.Inline : MaterializedSubResources.Heap;
+		for (U32 i = 0; i < GetNumSubResourceWords(); i++)
+		{
+			Words[i] |= InWords[i];
+		}
+	}
+
 	template<typename Handle>
 	const typename Handle::DescriptorType GetDescriptor(U32 SubResourceIndex) const
 	{
@@ -137,6 +215,9 @@ public:
 	virtual U32 GetResourceWidth(U32 SubResourceIndex) const = 0;
 	virtual U32 GetResourceHeight(U32 SubResourceIndex) const = 0;
 	virtual U32 GetNumSubResources() const = 0;
+	virtual U64 GetResourceByteSize() const = 0;
+	/* same descriptor, so both would materialize the same kind of resource, Other has to be created by the same handle */
+	virtual bool IsEquivalent(const TransientResourceBase& Other) const = 0;
 
 private:
 	virtual MaterializedResource* MaterializeInternal() const = 0;
@@ -177,6 +258,11 @@ public:
 	{
 		return TransientType::GetSubResourceCount(Descriptor);
 	}
+
+	U64 GetResourceByteSize() const final override
+	{
+		return TransientType::GetByteSize(Descriptor);
+	}
 };
 /* Specialized Transient resource Implementation */
 /* Handle is of ResourceHandle Type */
@@ -189,6 +275,11 @@ public:
 		: BaseType(InDescriptor)
 	{}
 
+	bool IsEquivalent(const TransientResourceBase& Other) const override
+	{
+		return checked_cast<const TransientResourceImpl&>(Other).Descriptor == this->Descriptor;
+	}
+
 private:
 	/* use the descriptor to create a resource and trigger OnMaterilize callback */
 	MaterializedResource* MaterializeInternal() const override
@@ -226,6 +317,12 @@ struct ResourceRevision
 		return ImaginaryResource != nullptr;
 	}
 
+	/* outputs of renderpasses that were not built yet have no resource but a lazy table as parent */
+	bool IsLazy() const
+	{
+		return ImaginaryResource == nullptr && Parent != nullptr;
+	}
+
 	bool operator!=(ResourceRevision Other) const
 	{
 		return!(*this == Other);
@@ -238,13 +335,17 @@ struct SubResourceRevision
 	U32 SubResourceIndex;
 };
 
+/* builds the lazy renderpasses a revision depends on and returns the revision they produced */
+inline SubResourceRevision ResolveLazyRevision(SubResourceRevision SubResource);
+
 template<typename Handle>
 struct ResourceRevisionInterface
 {
 	static const typename Handle::DescriptorType GetDescriptor(const SubResourceRevision& SubResource)
 	{
-		check(SubResource.Revision.IsValid());
-		return SubResource.Revision.ImaginaryResource->GetDescriptor<Handle>(SubResource.SubResourceIndex);
+		const SubResourceRevision Resolved = ResolveLazyRevision(SubResource);
+		check(Resolved.Revision.IsValid());
+		return Resolved.Revision.ImaginaryResource->GetDescriptor<Handle>(Resolved.SubResourceIndex);
 	}
 
 	/* forward the OnProcess callback to the Handles implementation and all of it's Resources*/
@@ -284,11 +385,13 @@ class ResourceTable : public IResourceTableBase
 	using CompatibleTypes = Set::Type<typename TS::CompatibleType...>;
 	static constexpr size_t StorageSize = sizeof...(TS) > 0 ? sizeof...(TS) : 1;
 
+	/* names and output flags are known at compile time, only the revisions and subresources are stored per instance */
+	static constexpr const char* HandleNames[StorageSize] = { TS::Name... };
+	static constexpr bool AreOutputResources[StorageSize] = { TS::IsOutputResource... };
+
 	const char* Name = nullptr;
-	const char* HandleNames[StorageSize];
 	ResourceRevision HandleRevisions[StorageSize];
 	U32 SubResourceIndicies[StorageSize];
-	bool AreOutputResources[StorageSize];
 
 public:
 	/*                   MakeFriends                    */
@@ -313,10 +416,8 @@ public:
 
 	explicit ResourceTable(const char* Name, const SubResourceRevision (&InSubResources)[sizeof...(TS)])
 		: Name(Name)
-		, HandleNames{ TS::Name... }
 		, HandleRevisions{ InSubResources[HandleTypes::template GetIndex<TS>()].Revision... }
 		, SubResourceIndicies{ InSubResources[HandleTypes::template GetIndex<TS>()].SubResourceIndex... }
-		, AreOutputResources{ TS::IsOutputResource... }
 	{
 		(void)InSubResources;
 	}
@@ -328,10 +429,8 @@ public:
 	>
 	explicit ResourceTable()
 		: Name("EmptyTable")
-		, HandleNames{ "DummyHandle" }
 		, HandleRevisions{ nullptr }
 		, SubResourceIndicies{ ALL_SUBRESOURCE_INDICIES }
-		, AreOutputResources{ false }
 	{}
 
 	/* assignment constructor from another resourcetable with SINFAE*/
@@ -586,6 +685,81 @@ public:
 	}
 };
 
+/* stands in as the parent of revisions that are only known after a lazy renderpass was built */
+/* the SubResourceIndex of such a revision is the index of the handle in the table the pass will return */
+class ILazyResourceTable : public IResourceTableInfo
+{
+public:
+	ILazyResourceTable() : IResourceTableInfo(nullptr) {}
+
+	/* build the renderpass if that did not happen yet and return the revision of its output */
+	virtual SubResourceRevision Resolve(U32 HandleIndex) const = 0;
+	/* true if Resolve does not have to build anything */
+	virtual bool IsBuilt() const = 0;
+	/* false if the revision depends on a pass that is still being built */
+	virtual bool CanResolve(U32 HandleIndex) const = 0;
+	/* the lazy table whose build makes the revision known, only asked while it is not built */
+	virtual const ILazyResourceTable* GetBlockingTable(U32 HandleIndex) const
+	{
+		return this;
+	}
+
+	/* there are no entries before the pass was built */
+	Iterator begin() const override
+	{
+		return Iterator{ this, nullptr, nullptr, nullptr, nullptr, 0, false };
+	}
+
+	Iterator end() const override
+	{
+		return Iterator{ this, nullptr, nullptr, nullptr, nullptr, 0, true };
+	}
+};
+
+inline SubResourceRevision ResolveLazyRevision(SubResourceRevision SubResource)
+{
+	while (SubResource.Revision.IsLazy())
+	{
+		SubResource = static_cast<const ILazyResourceTable*>(SubResource.Revision.Parent)->Resolve(SubResource.SubResourceIndex);
+	}
+	return SubResource;
+}
+
+inline bool CanResolveLazyRevision(const SubResourceRevision& SubResource)
+{
+	return !SubResource.Revision.IsLazy() || static_cast<const ILazyResourceTable*>(SubResource.Revision.Parent)->CanResolve(SubResource.SubResourceIndex);
+}
+
+/* check if a revision can be resolved without building any renderpass */
+inline bool IsLazyRevisionBuilt(SubResourceRevision SubResource)
+{
+	while (SubResource.Revision.IsLazy())
+	{
+		const ILazyResourceTable* LazyTable = static_cast<const ILazyResourceTable*>(SubResource.Revision.Parent);
+		if (!LazyTable->IsBuilt())
+		{
+			return false;
+		}
+		SubResource = LazyTable->Resolve(SubResource.SubResourceIndex);
+	}
+	return true;
+}
+
+/* the lazy renderpass that has to be built before the resource of the revision is known, null if it is known already */
+inline const ILazyResourceTable* FindUnbuiltLazyTable(SubResourceRevision SubResource)
+{
+	while (SubResource.Revision.IsLazy())
+	{
+		const ILazyResourceTable* LazyTable = static_cast<const ILazyResourceTable*>(SubResource.Revision.Parent);
+		if (!LazyTable->IsBuilt())
+		{
+			return LazyTable->GetBlockingTable(SubResource.SubResourceIndex);
+		}
+		SubResource = LazyTable->Resolve(SubResource.SubResourceIndex);
+	}
+	return nullptr;
+}
+
 template<typename ResourceTableType>
 class IterableResourceTable final : public ResourceTableType, public IResourceTableInfo
 {
@@ -606,12 +780,12 @@ private:
 
 	Iterator begin() const override
 	{
-		return Iterator{ this, &this->HandleNames[0], &this->HandleRevisions[0], &this->SubResourceIndicies[0], &this->AreOutputResources[0], this->Size(), false };
+		return Iterator{ this, &ResourceTableType::HandleNames[0], &this->HandleRevisions[0], &this->SubResourceIndicies[0], &ResourceTableType::AreOutputResources[0], this->Size(), false };
 	}
 
 	Iterator end() const override
 	{
-		return Iterator{ this, &this->HandleNames[0], &this->HandleRevisions[0], &this->SubResourceIndicies[0], &this->AreOutputResources[0], this->Size(), true };
+		return Iterator{ this, &ResourceTableType::HandleNames[0], &this->HandleRevisions[0], &this->SubResourceIndicies[0], &ResourceTableType::AreOutputResources[0], this->Size(), true };
 	}
 
 	/* First the tables are merged and than the results are linked to track the history */
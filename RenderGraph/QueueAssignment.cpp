@@ -0,0 +1,156 @@
+#include "QueueAssignment.h"
+#include "Assert.h"
+#include <algorithm>
+#include <stdio.h>
+
+static constexpr U32 NumQueues = U32(EGpuQueue::Count);
+
+void QueueAssignment::Assign(const std::vector<const IRenderPassAction*>& InSchedule, const std::vector<U32>& InPredecessorOffsets, const std::vector<U32>& InPredecessors, bool AsyncCompute, const AsyncComputePolicy& Policy)
+{
+	Actions = InSchedule;
+	const U32 NumActions = U32(Actions.size());
+	Queues.resize(NumActions);
+	for (U32 i = 0; i < NumActions; i++)
+	{
+		const bool UseAsyncCompute = AsyncCompute && Actions[i]->CanRunOnAsyncCompute() && (!Policy || Policy(*Actions[i]));
+		Queues[i] = UseAsyncCompute ? EGpuQueue::AsyncCompute : EGpuQueue::Graphics;
+	}
+
+	PredecessorOffsets = InPredecessorOffsets;
+	Predecessors = InPredecessors;
+	check(PredecessorOffsets.size() == NumActions + 1);
+
+	//a vector clock per action, the latest action of every queue that is known to be finished once the action finished
+	//positions are stored plus one so zero means nothing of that queue
+	std::vector<U32> Clocks(NumActions * NumQueues, 0);
+	U32 QueueClocks[NumQueues][NumQueues] = {};
+	Fences.clear();
+	NumCrossQueueDependencies = 0;
+	for (U32 i = 0; i < NumActions; i++)
+	{
+		const U32 Queue = U32(Queues[i]);
+		U32 LatestProducers[NumQueues] = {};
+		for (const U32* Iter = BeginPredecessors(i); Iter != EndPredecessors(i); ++Iter)
+		{
+			const U32 Producer = *Iter;
+			const U32 ProducerQueue = U32(Queues[Producer]);
+			if (ProducerQueue != Queue)
+			{
+				NumCrossQueueDependencies++;
+				LatestProducers[ProducerQueue] = std::max(LatestProducers[ProducerQueue], Producer + 1);
+			}
+		}
+
+		for (U32 OtherQueue = 0; OtherQueue < NumQueues; OtherQueue++)
+		{
+			const U32 Producer = LatestProducers[OtherQueue];
+			if (Producer == 0 || QueueClocks[Queue][OtherQueue] >= Producer)
+				continue;
+
+			Fences.push_back({ Producer - 1, i });
+			for (U32 q = 0; q < NumQueues; q++)
+			{
+				QueueClocks[Queue][q] = std::max(QueueClocks[Queue][q], Clocks[(Producer - 1) * NumQueues + q]);
+			}
+		}
+
+		QueueClocks[Queue][Queue] = i + 1;
+		std::copy(QueueClocks[Queue], QueueClocks[Queue] + NumQueues, Clocks.begin() + i * NumQueues);
+	}
+}
+
+U32 QueueAssignment::GetNumActionsOnQueue(EGpuQueue Queue) const
+{
+	return U32(std::count(Queues.begin(), Queues.end(), Queue));
+}
+
+U64 MultiQueueSimulator::GetActionCost(const IRenderPassAction* Action)
+{
+	//a fixed launch cost and one unit per kb the action writes
+	U64 Cost = 1;
+	for (const ResourceTableEntry& Entry : Action->GetRenderPassData())
+	{
+		const TransientResourceBase* Resource = Entry.GetImaginaryResource();
+		if (Entry.IsOutput() && Resource)
+		{
+			Cost += Resource->GetResourceByteSize() / 1024;
+		}
+	}
+	return Cost;
+}
+
+bool MultiQueueSimulator::Simulate(const QueueAssignment& Assignment)
+{
+	const U32 NumActions = Assignment.GetNumActions();
+	const std::vector<QueueAssignment::Fence>& Fences = Assignment.GetFences();
+	StartTimes.assign(NumActions, 0);
+	EndTimes.assign(NumActions, 0);
+	std::fill(std::begin(QueueBusyTimes), std::end(QueueBusyTimes), 0);
+	U64 QueueTimes[NumQueues] = {};
+	SerialTime = 0;
+	ParallelTime = 0;
+	NumViolations = 0;
+
+	//the queues run in submission order and only wait where a fence tells them to
+	auto NextFence = Fences.begin();
+	for (U32 i = 0; i < NumActions; i++)
+	{
+		const U32 Queue = U32(Assignment.GetQueue(i));
+		U64 Start = QueueTimes[Queue];
+		for (; NextFence != Fences.end() && NextFence->WaitAction == i; ++NextFence)
+		{
+			Start = std::max(Start, EndTimes[NextFence->SignalAction]);
+		}
+
+		const U64 Cost = GetActionCost(Assignment.GetAction(i));
+		StartTimes[i] = Start;
+		EndTimes[i] = Start + Cost;
+		QueueTimes[Queue] = EndTimes[i];
+		QueueBusyTimes[Queue] += Cost;
+		SerialTime += Cost;
+		ParallelTime = std::max(ParallelTime, EndTimes[i]);
+
+		for (const U32* Iter = Assignment.BeginPredecessors(i); Iter != Assignment.EndPredecessors(i); ++Iter)
+		{
+			if (EndTimes[*Iter] > Start)
+			{
+				NumViolations++;
+			}
+		}
+	}
+
+	//the actions of a queue never overlap each other, so the overlap is the intersection of the graphics and the compute intervals
+	OverlapTime = 0;
+	U32 Compute = 0;
+	for (U32 Graphics = 0; Graphics < NumActions; Graphics++)
+	{
+		if (Assignment.GetQueue(Graphics) != EGpuQueue::Graphics)
+			continue;
+
+		for (; Compute < NumActions; Compute++)
+		{
+			if (Assignment.GetQueue(Compute) != EGpuQueue::AsyncCompute)
+				continue;
+			if (StartTimes[Compute] >= EndTimes[Graphics])
+				break;
+
+			const U64 OverlapStart = std::max(StartTimes[Compute], StartTimes[Graphics]);
+			const U64 OverlapEnd = std::min(EndTimes[Compute], EndTimes[Graphics]);
+			OverlapTime += OverlapEnd > OverlapStart ? OverlapEnd - OverlapStart : 0;
+			//the compute action might still overlap the next graphics action
+			if (EndTimes[Compute] > EndTimes[Graphics])
+				break;
+		}
+	}
+
+	NumFences = U32(Fences.size());
+	NumCrossQueueDependencies = Assignment.GetNumCrossQueueDependencies();
+	return NumViolations == 0;
+}
+
+void MultiQueueSimulator::Print() const
+{
+	printf("Queues: graphics busy: %llu compute busy: %llu serial: %llu parallel: %llu overlap: %llu \n", (unsigned long long)QueueBusyTimes[U32(EGpuQueue::Graphics)],
+		(unsigned long long)QueueBusyTimes[U32(EGpuQueue::AsyncCompute)], (unsigned long long)SerialTime, (unsigned long long)ParallelTime, (unsigned long long)OverlapTime);
+	printf("Queue sync: %u fences for %u cross queue dependencies, %u ordering violations \n", NumFences, NumCrossQueueDependencies, NumViolations);
+}
\ No newline at end of file
@@ -0,0 +1,139 @@
+#pragma once
+#include "Renderpass.h"
+#include "Types.h"
+#include <functional>
+#include <vector>
+
+enum class EGpuQueue : U8
+{
+	Graphics,
+	AsyncCompute,
+	Count
+};
+
+/* decides the queue of every scheduled action and derives the fences the queues need between each other */
+/* the dependencies between the actions are given by the caller, GraphProcessor passes the ones of GraphProcessor::BuildDependencies */
+/* a dependency on the same queue is kept by the submission order, across queues only the latest producer per queue is waited for */
+/* and only if the waiting queue did not already see it through an earlier fence, so the fences are the minimal set for the schedule */
+class QueueAssignment
+{
+public:
+	/* the action at SignalAction signals when it finished, the action at WaitAction waits for it before it starts, both are schedule positions */
+	struct Fence
+	{
+		U32 SignalAction;
+		U32 WaitAction;
+	};
+
+	/* decides per pass which of the actions the handles allow on async compute really go there, without one all of them do */
+	using AsyncComputePolicy = std::function<bool(const IRenderPassAction&)>;
+
+	/* the predecessors of every action are schedule positions as a CSR, each one before the action and only listed once */
+	/* with async compute off every action runs on the graphics queue */
+	void Assign(const std::vector<const IRenderPassAction*>& InSchedule, const std::vector<U32>& InPredecessorOffsets, const std::vector<U32>& InPredecessors, bool AsyncCompute, const AsyncComputePolicy& Policy = nullptr);
+
+	U32 GetNumActions() const
+	{
+		return U32(Actions.size());
+	}
+
+	const IRenderPassAction* GetAction(U32 Action) const
+	{
+		return Actions[Action];
+	}
+
+	EGpuQueue GetQueue(U32 Action) const
+	{
+		return Queues[Action];
+	}
+
+	/* the positions of the actions that have to be finished before the action starts */
+	const U32* BeginPredecessors(U32 Action) const
+	{
+		return Predecessors.data() + PredecessorOffsets[Action];
+	}
+
+	const U32* EndPredecessors(U32 Action) const
+	{
+		return Predecessors.data() + PredecessorOffsets[Action + 1];
+	}
+
+	/* fences sorted by the action that waits */
+	const std::vector<Fence>& GetFences() const
+	{
+		return Fences;
+	}
+
+	/* dependencies between actions on different queues, the fences cover all of them */
+	U32 GetNumCrossQueueDependencies() const
+	{
+		return NumCrossQueueDependencies;
+	}
+
+	U32 GetNumActionsOnQueue(EGpuQueue Queue) const;
+
+	void Reset()
+	{
+		Actions.clear();
+		Queues.clear();
+		PredecessorOffsets.assign(1, 0);
+		Predecessors.clear();
+		Fences.clear();
+		NumCrossQueueDependencies = 0;
+	}
+
+private:
+	std::vector<const IRenderPassAction*> Actions;
+	std::vector<EGpuQueue> Queues;
+	std::vector<U32> PredecessorOffsets = { 0 };
+	std::vector<U32> Predecessors;
+	std::vector<Fence> Fences;
+	U32 NumCrossQueueDependencies = 0;
+};
+
+/* runs a queue assignment on simulated queues that work in parallel, every action takes as long as it takes to write its outputs */
+/* validates that each action only starts once all of its dependencies finished and reports how much work the queues overlapped */
+class MultiQueueSimulator
+{
+public:
+	/* returns false if an action could start before one of its dependencies finished */
+	bool Simulate(const QueueAssignment& Assignment);
+
+	/* time to run everything on one queue */
+	U64 GetSerialTime() const
+	{
+		return SerialTime;
+	}
+
+	/* time until the last queue finished */
+	U64 GetParallelTime() const
+	{
+		return ParallelTime;
+	}
+
+	/* time both queues were busy at once */
+	U64 GetOverlapTime() const
+	{
+		return OverlapTime;
+	}
+
+	U32 GetNumViolations() const
+	{
+		return NumViolations;
+	}
+
+	void Print() const;
+
+private:
+	static U64 GetActionCost(const IRenderPassAction* Action);
+
+	std::vector<U64> StartTimes;
+	std::vector<U64> EndTimes;
+	U64 QueueBusyTimes[U32(EGpuQueue::Count)] = {};
+	U64 SerialTime = 0;
+	U64 ParallelTime = 0;
+	U64 OverlapTime = 0;
+	U32 NumViolations = 0;
+	U32 NumFences = 0;
+	U32 NumCrossQueueDependencies = 0;
+};
\ No newline at end of file
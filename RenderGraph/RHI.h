@@ -3,38 +3,230 @@
 #include "Types.h"
 #include "ExampleResourceTypes.h"
 #include <iostream>
+#include <vector>
 
 struct RenderResourceBase;
 struct RenderPassBase;
+struct ImmediateRenderContext;
+
+/* a begin barrier starts a split transition, the next full barrier of the texture to the same state ends it */
+enum class EBarrierType : U8
+{
+	Full,
+	Begin,
+};
+
+struct ResourceBarrier
+{
+	const Texture2d* Texture;
+	EResourceTransition::Type Transition;
+	EBarrierType Type;
+};
+
+/* what a deferred context recorded, replayed on an immediate context in submission order */
+/* transitions are resolved on submit as only then the state of a texture is known */
+class RenderCommandList
+{
+public:
+	enum class ECommandType : U8
+	{
+		TransitionResource,
+		BindTexture,
+		BindRenderTarget,
+		Draw,
+		ResourceBarriers,
+	};
+
+	struct Command
+	{
+		ECommandType Type;
+		const Texture2d* Texture;
+		const char* Name;
+		U32 Value;
+	};
+
+	void AddCommand(ECommandType Type, const Texture2d* Texture, const char* Name = nullptr, U32 Value = 0)
+	{
+		Commands.push_back({ Type, Texture, Name, Value });
+	}
+
+	void AddBarrier(const Texture2d* Texture, EResourceTransition::Type Transition, EBarrierType Type)
+	{
+		Barriers.push_back({ Texture, Transition, Type });
+	}
+
+	/* the barriers added since the last flush become one batch */
+	void FlushBarriers()
+	{
+		const U32 NumPendingBarriers = U32(Barriers.size()) - NumFlushedBarriers;
+		if (NumPendingBarriers > 0)
+		{
+			AddCommand(ECommandType::ResourceBarriers, nullptr, nullptr, NumPendingBarriers);
+			NumFlushedBarriers = U32(Barriers.size());
+		}
+	}
+
+	void Submit(ImmediateRenderContext& RndCtx) const;
+
+	size_t GetNumCommands() const
+	{
+		return Commands.size();
+	}
+
+	void Reset()
+	{
+		Commands.clear();
+		Barriers.clear();
+		NumFlushedBarriers = 0;
+	}
+
+private:
+	std::vector<Command> Commands;
+	/* the barriers of all batches in order, every batch command takes the next Value of them */
+	std::vector<ResourceBarrier> Barriers;
+	U32 NumFlushedBarriers = 0;
+};
+
+/* how many barrier calls an immediate context issued, without batching every transition would be a call of its own */
+struct BarrierStats
+{
+	U32 NumTransitions = 0;
+	U32 NumBatches = 0;
+	U32 LargestBatch = 0;
+	/* transitions that were begun early and ended in a later batch, both halves count in NumTransitions */
+	U32 NumSplitTransitions = 0;
+};
 
 struct RenderContextBase
 {
 private:
 	static constexpr const char* TransitionStr[] = { "Texture", "Target", "UAV", "DepthTexture", "DepthTarget", "Undefined" };
 
-public:
-	void TransitionResource(const struct Texture2d& Tex, EResourceTransition::Type Transition)
+	bool ExecuteTransition(const struct Texture2d& Tex, EResourceTransition::Type Transition)
 	{
 		static_assert(sizeofArray(TransitionStr) == EResourceTransition::Undefined + 1, "Array out of bounds check failed");
 		EResourceTransition::Type OldState;
+		if (Tex.EndTransition(OldState, Transition))
+		{
+			printf("EndTransition: %s from %s to: %s \n", Tex.GetName(), TransitionStr[OldState], TransitionStr[Transition]);
+			return true;
+		}
 		if (Tex.RequiresTransition(OldState, Transition))
 		{
 			printf("TransitionTexture: %s from %s to: %s \n", Tex.GetName(), TransitionStr[OldState], TransitionStr[Transition]);
+			return true;
+		}
+		return false;
+	}
+
+	bool ExecuteBeginTransition(const struct Texture2d& Tex, EResourceTransition::Type Transition)
+	{
+		EResourceTransition::Type OldState;
+		if (Tex.BeginTransition(OldState, Transition))
+		{
+			printf("BeginTransition: %s from %s to: %s \n", Tex.GetName(), TransitionStr[OldState], TransitionStr[Transition]);
+			return true;
+		}
+		return false;
+	}
+
+protected:
+	/* set for deferred contexts, everything is recorded into it instead of executed */
+	RenderCommandList* CommandList = nullptr;
+	/* barriers of an immediate context waiting for FlushBarriers */
+	std::vector<ResourceBarrier> PendingBarriers;
+	BarrierStats Stats;
+
+public:
+	void TransitionResource(const struct Texture2d& Tex, EResourceTransition::Type Transition)
+	{
+		if (CommandList)
+		{
+			CommandList->AddCommand(RenderCommandList::ECommandType::TransitionResource, &Tex, nullptr, Transition);
+			return;
+		}
+		if (ExecuteTransition(Tex, Transition))
+		{
+			Stats.NumTransitions++;
+			Stats.NumBatches++;
+			Stats.LargestBatch = Stats.LargestBatch > 1 ? Stats.LargestBatch : 1;
+		}
+	}
+
+	/* gathers a transition for the next FlushBarriers */
+	void AddBarrier(const struct Texture2d& Tex, EResourceTransition::Type Transition, EBarrierType Type = EBarrierType::Full)
+	{
+		if (CommandList)
+		{
+			CommandList->AddBarrier(&Tex, Transition, Type);
+			return;
+		}
+		PendingBarriers.push_back({ &Tex, Transition, Type });
+	}
+
+	/* issues the gathered transitions as one barrier call, transitions to the state a texture is already in drop out of the batch */
+	void FlushBarriers()
+	{
+		if (CommandList)
+		{
+			CommandList->FlushBarriers();
+			return;
+		}
+		ResourceBarriers(PendingBarriers.data(), U32(PendingBarriers.size()));
+		PendingBarriers.clear();
+	}
+
+	void ResourceBarriers(const ResourceBarrier* Barriers, U32 NumBarriers)
+	{
+		U32 BatchSize = 0;
+		for (U32 i = 0; i < NumBarriers; i++)
+		{
+			if (Barriers[i].Type == EBarrierType::Begin)
+			{
+				const bool Begun = ExecuteBeginTransition(*Barriers[i].Texture, Barriers[i].Transition);
+				BatchSize += Begun ? 1 : 0;
+				Stats.NumSplitTransitions += Begun ? 1 : 0;
+			}
+			else
+			{
+				BatchSize += ExecuteTransition(*Barriers[i].Texture, Barriers[i].Transition) ? 1 : 0;
+			}
+		}
+		if (BatchSize > 0)
+		{
+			Stats.NumTransitions += BatchSize;
+			Stats.NumBatches++;
+			Stats.LargestBatch = Stats.LargestBatch > BatchSize ? Stats.LargestBatch : BatchSize;
 		}
 	}
 
 	void BindTexture(const struct Texture2d& Tex, U32 SubResourceIndex)
 	{
+		if (CommandList)
+		{
+			CommandList->AddCommand(RenderCommandList::ECommandType::BindTexture, &Tex, nullptr, SubResourceIndex);
+			return;
+		}
 		printf("BindTexture: %s SubResource:%i \n", Tex.GetName(), SubResourceIndex);
 	}
 
 	void BindRenderTarget(const struct Texture2d& Tex)
 	{
+		if (CommandList)
+		{
+			CommandList->AddCommand(RenderCommandList::ECommandType::BindRenderTarget, &Tex);
+			return;
+		}
 		printf("BindRenderTarget: %s \n", Tex.GetName());
 	}
 
 	void Draw(const char* RenderPass)
 	{
+		if (CommandList)
+		{
+			CommandList->AddCommand(RenderCommandList::ECommandType::Draw, nullptr, RenderPass);
+			return;
+		}
 		printf("Drawing Renderpass: %s \n", RenderPass);
 		printf("/********************************/ \n");
 	}
@@ -46,8 +238,103 @@ struct RenderContext : protected RenderContextBase
 	using RenderContextBase::Draw;
 };
 
-struct ImmediateRenderContext final : public RenderContext
+/* the context the compiled commands of an action run on, the tasks only see the RenderContext part of it */
+struct CommandRenderContext : public RenderContext
 {
 	using RenderContextBase::TransitionResource;
 	using RenderContextBase::BindRenderTarget;
-};
\ No newline at end of file
+	using RenderContextBase::AddBarrier;
+	using RenderContextBase::FlushBarriers;
+};
+
+struct ImmediateRenderContext final : public CommandRenderContext
+{
+	using RenderContextBase::ResourceBarriers;
+
+	const BarrierStats& GetBarrierStats() const
+	{
+		return Stats;
+	}
+};
+
+/* handles transition and bind through the context they are given, these two split what a handle does into its transitions and its binds */
+/* so the transitions of all handles of an action can be gathered and flushed as one batch before anything is bound */
+struct BarrierGatherContext
+{
+	CommandRenderContext& Ctx;
+
+	void TransitionResource(const Texture2d& Tex, EResourceTransition::Type Transition)
+	{
+		Ctx.AddBarrier(Tex, Transition);
+	}
+
+	void BindTexture(const Texture2d&, U32) {}
+	void BindRenderTarget(const Texture2d&) {}
+};
+
+/* only lists the transitions of the handles, for passes that plan the barriers of a schedule before it runs */
+struct BarrierListContext
+{
+	std::vector<ResourceBarrier>& Barriers;
+
+	void TransitionResource(const Texture2d& Tex, EResourceTransition::Type Transition)
+	{
+		Barriers.push_back({ &Tex, Transition, EBarrierType::Full });
+	}
+
+	void BindTexture(const Texture2d&, U32) {}
+	void BindRenderTarget(const Texture2d&) {}
+};
+
+struct BindingContext
+{
+	CommandRenderContext& Ctx;
+
+	void TransitionResource(const Texture2d&, EResourceTransition::Type) {}
+
+	void BindTexture(const Texture2d& Tex, U32 SubResourceIndex)
+	{
+		Ctx.BindTexture(Tex, SubResourceIndex);
+	}
+
+	void BindRenderTarget(const Texture2d& Tex)
+	{
+		Ctx.BindRenderTarget(Tex);
+	}
+};
+
+/* records into its own command list so several of them can be recorded on different threads */
+struct DeferredRenderContext final : public CommandRenderContext
+{
+	explicit DeferredRenderContext(RenderCommandList& InCommandList)
+	{
+		CommandList = &InCommandList;
+	}
+};
+
+inline void RenderCommandList::Submit(ImmediateRenderContext& RndCtx) const
+{
+	U32 FirstBarrier = 0;
+	for (const Command& Cmd : Commands)
+	{
+		switch (Cmd.Type)
+		{
+		case ECommandType::TransitionResource:
+			RndCtx.TransitionResource(*Cmd.Texture, EResourceTransition::Type(Cmd.Value));
+			break;
+		case ECommandType::BindTexture:
+			RndCtx.BindTexture(*Cmd.Texture, Cmd.Value);
+			break;
+		case ECommandType::BindRenderTarget:
+			RndCtx.BindRenderTarget(*Cmd.Texture);
+			break;
+		case ECommandType::Draw:
+			RndCtx.Draw(Cmd.Name);
+			break;
+		case ECommandType::ResourceBarriers:
+			RndCtx.ResourceBarriers(Barriers.data() + FirstBarrier, Cmd.Value);
+			FirstBarrier += Cmd.Value;
+			break;
+		}
+	}
+}
\ No newline at end of file
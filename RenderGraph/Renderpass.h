@@ -3,8 +3,13 @@
 #include "Sequence.h"
 #include "Plumber.h"
 #include "RHI.h"
+#include "ExecutionPlan.h"
+#include "TaskScheduler.h"
 #include "Sequence.h"
 #include <vector>
+#include <unordered_map>
+#include <optional>
+#include <algorithm>
 
 /* Base class of all actions which can contain dispatches or draws */
 struct IRenderPassAction
@@ -13,16 +18,37 @@ struct IRenderPassAction
 
 	virtual ~IRenderPassAction() {}
 	virtual const class IResourceTableInfo& GetRenderPassData() const = 0;
-	virtual void Execute(struct ImmediateRenderContext&) const {};
+	/* append the transitions, bindings and the task of the action to the plan, the plan is the only way actions run */
+	virtual void CompileCommands(ExecutionPlan&) const {};
+	/* the transitions the handles of the action need, in the order the compiled commands gather them */
+	virtual void GatherBarriers(std::vector<struct ResourceBarrier>&) const {};
+	/* tasks that take the immediate context can not be recorded into a deferred command list */
+	virtual bool RequiresImmediateContext() const { return false; }
+	/* actions that write and bind no handle which needs the rasterizer may run on the async compute queue */
+	virtual bool CanRunOnAsyncCompute() const { return false; }
 
 	const char* GetName() const { return Name; };
+
+	/* actions with the same task type run the same code, tasks that carry state have no type as they can not be compared */
+	virtual const void* GetTaskType() const { return nullptr; }
 	
 	/* coloring is used to find independent paths though the graph */
 	void SetColor(U32 InColor) const { Color = InColor; }
 	U32 GetColor() const { return Color; }
+
+	/* position in the schedule the GraphProcessor runs as tasks, only valid while that schedule has this action at the position */
+	void SetTaskIndex(U32 InTaskIndex) const { TaskIndex = InTaskIndex; }
+	U32 GetTaskIndex() const { return TaskIndex; }
+
+	/* position in the action list of the builder that recorded it */
+	U32 GetRecordIndex() const { return RecordIndex; }
 private:
+	friend struct RenderPassBuilder;
+
 	const char* Name = nullptr;
 	mutable U32 Color = UINT_MAX; //the node is culled to begin with
+	mutable U32 TaskIndex = UINT_MAX;
+	U32 RecordIndex = UINT_MAX;
 };
 
 struct RenderPassBuilder
@@ -31,6 +57,56 @@ private:
 	using ActionListType = std::vector<const IRenderPassAction*>;
 	mutable ActionListType ActionList;
 
+	/* recorded actions by the hash of their task type and inputs, only filled when deduplicating */
+	mutable std::unordered_multimap<U64, U32> ActionsByInput;
+	/* the record index of the last action that wrote each resource, only filled when deduplicating */
+	mutable std::unordered_map<const TransientResourceBase*, U32> LastWriters;
+	mutable U32 NumDeduplicatedActions = 0;
+	bool DeduplicateActions = false;
+
+	/* hash over the names, handles, descriptors and edges of all recorded actions, only recorded with the graph keys */
+	mutable U64 StructuralHash = 0;
+	/* what culling, scheduling and materialization depend on in the order ActionGraph would compile it, see AddGraphKeys */
+	mutable std::vector<U64> GraphKeys;
+	/* the resources by the dense id the keys use, the order they were first touched in */
+	mutable std::vector<const TransientResourceBase*> GraphKeyResources;
+	bool GraphKeyRecording = false;
+
+	/* lazy renderpasses in the order they were recorded, started ones stay in the list, only filled when building lazily */
+	struct ILazyRenderPass;
+	mutable std::vector<const ILazyRenderPass*> PendingLazyPasses;
+	/* the lazy passes that were not started, filed by what their inputs are known to be so far */
+	/* that is the resource, or the lazy pass that has to be built first, so a write only looks at the passes that read the resource */
+	struct LazyReader
+	{
+		const ILazyRenderPass* Pass;
+		U32 Next;
+	};
+	struct LazyReaderList
+	{
+		const void* Input;
+		U32 First;
+		U32 Last;
+	};
+	mutable std::vector<LazyReaderList> LazyReaderLists;
+	mutable std::vector<LazyReader> LazyReaders;
+	mutable U32 LazyPassScanDepth = 0;
+	/* number of lazy passes being built, only passes recorded outside of them are deferred */
+	mutable U32 LazyBuildDepth = 0;
+	bool LazyPassBuilding = false;
+
+	/* runs the tasks of BuildParallel, without one they run on the calling thread */
+	TaskScheduler* Scheduler = nullptr;
+
+	/* the actions a BuildParallel task recorded so far, they are appended to the ActionList once all tasks finished */
+	struct TaskRecording
+	{
+		const RenderPassBuilder* Builder = nullptr;
+		std::vector<IRenderPassAction*>* Actions = nullptr;
+		TaskRecording* Outer = nullptr;
+	};
+	static inline thread_local TaskRecording* CurrentTaskRecording = nullptr;
+
 public:
 	RenderPassBuilder(const RenderPassBuilder&) = delete;
 	RenderPassBuilder(){}
@@ -52,14 +128,27 @@ public:
 		const RenderPassBuilder* Self = this;
 		return Seq([&, Self, Name](const InputTableType& input)
 		{
-			CheckIsValidResourceTable(input);		
+			CheckIsValidResourceTable(input);
+			if constexpr (NestedOutputTableType::Size() > 0)
+			{
+				//passes recorded while a lazy pass is built are built right away, a thunk per nested pass costs more than the builds it could skip
+				if (Self->LazyPassBuilding && Self->LazyBuildDepth == 0 && !Self->IsRecordingTask())
+				{
+					//the pass is built after this sequence is gone so it needs copies of the function and the arguments
+					auto LazyBuildFunction = [Self, Name, BuildFunction, Args...](const InputTableType& LazyInput)
+					{
+						return NestedOutputTableType(Name, BuildFunction(*Self, LazyInput, Args...));
+					};
+					return Self->RecordLazyRenderPass<NestedOutputTableType>(Name, input, LazyBuildFunction);
+				}
+			}
 			//no heap allocation just run the build and merge the results (no linking as these are not real types!)
 			return NestedOutputTableType(Name, BuildFunction(*Self, input, Args...));
 		});
 	}
 
 	template<typename FunctionType>
-	auto QueueRenderAction(const char* Name, const FunctionType& QueuedTask) const
+	auto QueueRenderAction(const char* Name, const FunctionType& QueuedTask, ERenderActionFlags::Type Flags = ERenderActionFlags::Default) const
 	{
 		/* sanity checking if the passed in variables make sense, otherwise fail early */
 		typedef Traits::function_traits<FunctionType> Traits; 
@@ -70,20 +159,31 @@ public:
 		static_assert(std::is_base_of_v<IResourceTableBase, InputTableType>, "The 2nd parameter must be a resource table");
 		typedef std::decay_t<typename Traits::return_type> VoidReturnType;
 		static_assert(std::is_same_v<void, VoidReturnType>, "The returntype must be void");
+		check(!Any(Flags, ERenderActionFlags::Deduplicate) || std::is_empty_v<FunctionType>);
 		
-		ActionListType& LocalActionList = ActionList;
-		return Seq([&LocalActionList, QueuedTask, Name](const InputTableType& input)
+		const RenderPassBuilder* Self = this;
+		return Seq([Self, QueuedTask, Name, Flags](const InputTableType& input)
 		{
 			CheckIsValidResourceTable(input);
 
 			typedef TRenderPassAction<ContextType, InputTableType, FunctionType> RenderActionType;
 
-			/* create some space on the heap for the action as those are nodes of our graph */
-			RenderActionType* NewRenderAction = new (LinearAlloc<RenderActionType>()) RenderActionType(Name, input, QueuedTask);
-			LocalActionList.push_back(NewRenderAction);
-
 			//extract the resources which can be written to (like UAVs and Rendertargets)
 			using WritableSetType = decltype(Set::template Filter<IsMutableOp>(typename InputTableType::HandleTypes()));
+
+			//this action needs the outputs of the lazy renderpasses it reads
+			InputTableType ResolvedInput = input;
+			Self->ResolveLazyInputs(ResolvedInput);
+
+			/* create some space on the heap for the action as those are nodes of our graph */
+			RenderActionType* NewRenderAction = new (LinearAlloc<RenderActionType>()) RenderActionType(Name, ResolvedInput, QueuedTask);
+			if (const IRenderPassAction* EquivalentAction = Self->FindEquivalentAction(NewRenderAction, Flags))
+			{
+				//the same task type guarantees the same action type, continue with the outputs of the earlier action
+				return static_cast<const RenderActionType*>(EquivalentAction)->RenderPassData.Link(WritableSetType());
+			}
+			Self->RecordAction(NewRenderAction);
+
 			// merge and link (have the outputs point at this action from now on).
 			return NewRenderAction->RenderPassData.Link(WritableSetType());
 		});
@@ -98,7 +198,7 @@ public:
 			typedef typename std::decay<decltype(s)>::type StateType;
 			static_assert(StateType::template Contains<Handle>(), "Source was not found in the resource table");
 
-			SubResourceRevision SubResource = s.template GetSubResource<Handle>();
+			SubResourceRevision SubResource = ResolveLazyRevision(s.template GetSubResource<Handle>());
 			SubResource.Revision.Parent = nullptr;
 
 			//remove the old output and copy it into the new destination
@@ -125,9 +225,14 @@ public:
 			static_assert(To::template IsConvertible<From>(), "HandleTypes do not match");
 			//remove the old output and copy it into the new destination
 			SubResourceRevision SubResource = s.template GetSubResource<From>();
-			U32 NumSubResources = SubResource.Revision.ImaginaryResource->GetNumSubResources();
-			SubResource.SubResourceIndex = (DestinationSubResourceIndex == ALL_SUBRESOURCE_INDICIES) && (NumSubResources == 1) ? 0 : DestinationSubResourceIndex;
-			return ResourceTable<To>{ "RenameAllEntries", { SubResource } };
+			if (SubResource.Revision.IsLazy())
+			{
+				//renaming is no reason to build the pass, the new entry resolves the old one when it is needed
+				SubResource.Revision.Parent = LinearNew<LazyAssignedEntry>(SubResource, DestinationSubResourceIndex);
+				SubResource.SubResourceIndex = 0;
+				return ResourceTable<To>{ "RenameAllEntries", { SubResource } };
+			}
+			return ResourceTable<To>{ "RenameAllEntries", { AssignSubResource(SubResource, DestinationSubResourceIndex) } };
 		});
 	}
 
@@ -140,6 +245,138 @@ public:
 	void Reset()
 	{
 		ActionList.clear();
+		ActionsByInput.clear();
+		LastWriters.clear();
+		NumDeduplicatedActions = 0;
+		StructuralHash = 0;
+		GraphKeys.clear();
+		GraphKeyResources.clear();
+		PendingLazyPasses.clear();
+		LazyReaderLists.clear();
+		LazyReaders.clear();
+	}
+
+	/* record the graph keys and the structural hash along with the actions, only a GraphProcessor that caches by them needs them */
+	void SetGraphKeyRecording(bool InGraphKeyRecording)
+	{
+		GraphKeyRecording = InGraphKeyRecording;
+	}
+
+	bool IsRecordingGraphKeys() const
+	{
+		return GraphKeyRecording;
+	}
+
+	/* equal for two recordings that produce the same graph, so culling and scheduling results can be cached under it */
+	U64 GetStructuralHash() const
+	{
+		return StructuralHash;
+	}
+
+	/* two recordings with equal keys produce the same graph, a cached result found by the structural hash is verified with them */
+	const std::vector<U64>& GetGraphKeys() const
+	{
+		return GraphKeys;
+	}
+
+	const std::vector<const TransientResourceBase*>& GetGraphKeyResources() const
+	{
+		return GraphKeyResources;
+	}
+
+	/* an action queued with ERenderActionFlags::Deduplicate is not recorded again when an earlier one has the same task type and inputs */
+	/* its consumers read the outputs of the earlier one */
+	void SetDeduplicateActions(bool InDeduplicateActions)
+	{
+		DeduplicateActions = InDeduplicateActions;
+	}
+
+	U32 GetNumDeduplicatedActions() const
+	{
+		return NumDeduplicatedActions;
+	}
+
+	/* BuildRenderPass only records the pass, it is built once an action, a descriptor query or ResolveLazyPasses needs one of its outputs */
+	/* the passes it records while it is built are not deferred, so laziness skips whole top level passes and not their parts */
+	void SetLazyPassBuilding(bool InLazyPassBuilding)
+	{
+		LazyPassBuilding = InLazyPassBuilding;
+	}
+
+	bool IsLazyPassBuilding() const
+	{
+		return LazyPassBuilding;
+	}
+
+	/* lazy renderpasses nothing asked for so far */
+	U32 GetNumSkippedLazyPasses() const
+	{
+		return U32(std::count_if(PendingLazyPasses.begin(), PendingLazyPasses.end(), [](const ILazyRenderPass* LazyPass) { return !LazyPass->IsStarted(); }));
+	}
+
+	/* BuildParallel runs its tasks on the scheduler, the builder does not own it */
+	void SetTaskScheduler(TaskScheduler* InScheduler)
+	{
+		Scheduler = InScheduler;
+	}
+
+	/* records Count independent sub sequences as tasks and hands their results to Combine in the order of the indices */
+	/* the actions of a task are appended right before the ones Combine records for it, so the graph is the one of a serial loop calling both */
+	/* renderpasses in a task are built eagerly and its actions are not deduplicated, as both need the shared state of the builder */
+	/* without a scheduler or with one that can not run in parallel the loop just runs serially on the calling thread */
+	template<typename FunctionType, typename CombineType>
+	void BuildParallel(U32 Count, const FunctionType& Function, const CombineType& Combine) const
+	{
+		typedef std::decay_t<decltype(Function(U32()))> ResultTableType;
+		static_assert(std::is_base_of_v<IResourceTableBase, ResultTableType>, "The returntype must be a resource table");
+
+		if (!Scheduler || !Scheduler->RunsInParallel())
+		{
+			for (U32 i = 0; i < Count; i++)
+			{
+				Combine(i, Function(i));
+			}
+			return;
+		}
+
+		//a task might get lazy revisions from outside, resolving them must not build anything on another thread
+		//passes that wait for one that is being built right now can not be seen by the tasks, they stay lazy
+		BuildPendingLazyPasses();
+
+		std::vector<std::optional<ResultTableType>> TaskResults(Count);
+		std::vector<std::vector<IRenderPassAction*>> TaskActions(Count);
+		Scheduler->ParallelFor(Count, [this, &Function, &TaskResults, &TaskActions](U32 Index)
+		{
+			TaskRecording Recording = { this, &TaskActions[Index], CurrentTaskRecording };
+			CurrentTaskRecording = &Recording;
+			TaskResults[Index].emplace(Function(Index));
+			CurrentTaskRecording = Recording.Outer;
+		});
+
+		for (U32 i = 0; i < Count; i++)
+		{
+			for (IRenderPassAction* Action : TaskActions[i])
+			{
+				RecordAction(Action);
+			}
+			Combine(i, *TaskResults[i]);
+		}
+	}
+
+	/* the handles are the outputs of the graph, the lazy renderpasses they depend on are built now */
+	template<typename... Handles>
+	auto ResolveLazyPasses() const
+	{
+		return Seq([](const auto& s)
+		{
+			CheckIsValidResourceTable(s);
+			typedef typename std::decay<decltype(s)>::type StateType;
+			static_assert((StateType::template Contains<Handles>() && ...), "Handle was not found in the resource table");
+
+			StateType ResolvedTable = s;
+			(ResolveLazyEntry<Handles>(ResolvedTable), ...);
+			return ResolvedTable;
+		});
 	}
 
 	/* this function adds a new resource to the resourcetable all descriptors have to be provided */ 
@@ -160,6 +397,489 @@ public:
 	}
 
 private:
+	/* a renderpass that is built on demand, its outputs have it as their parent until then */
+	struct ILazyRenderPass : ILazyResourceTable
+	{
+		virtual void Build() const = 0;
+		virtual bool IsStarted() const = 0;
+		/* false while a pass this one reads from is still being built */
+		virtual bool CanBuild() const = 0;
+		/* file the pass under every input, by its resource or by the lazy pass that still has to produce it */
+		virtual void AddToLazyReaders() const = 0;
+		/* the passes filed under this one until it is built */
+		mutable U32 LazyReaderList = ~0u;
+	};
+
+	template<typename InputTableType, typename OutputTableType, typename BuildFunctionType>
+	struct TLazyRenderPass final : ILazyRenderPass
+	{
+		TLazyRenderPass(const RenderPassBuilder* InBuilder, const char* InName, const InputTableType& InInput, const BuildFunctionType& InBuildFunction)
+			: Builder(InBuilder)
+			, Name(InName)
+			, Input(InInput)
+			, BuildFunction(InBuildFunction) {}
+
+		const char* GetName() const override
+		{
+			return Name;
+		}
+
+		void Build() const override
+		{
+			if (!Started)
+			{
+				Started = true;
+				Builder->LazyBuildDepth++;
+				Output.emplace(BuildFunction(Input));
+				Builder->LazyBuildDepth--;
+				Builder->OnLazyPassBuilt(this);
+			}
+		}
+
+		bool IsStarted() const override
+		{
+			return Started;
+		}
+
+		bool IsBuilt() const override
+		{
+			return Output.has_value();
+		}
+
+		bool CanResolve(U32 HandleIndex) const override
+		{
+			if (Output)
+			{
+				return CanResolveLazyRevision({ Output->HandleRevisions[HandleIndex], Output->SubResourceIndicies[HandleIndex] });
+			}
+			return !Started && CanBuild();
+		}
+
+		bool CanBuild() const override
+		{
+			for (size_t i = 0; i < InputTableType::Size(); i++)
+			{
+				if (!CanResolveLazyRevision({ Input.HandleRevisions[i], Input.SubResourceIndicies[i] }))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		SubResourceRevision Resolve(U32 HandleIndex) const override
+		{
+			Build();
+			check(Output.has_value());
+			return { Output->HandleRevisions[HandleIndex], Output->SubResourceIndicies[HandleIndex] };
+		}
+
+		void AddToLazyReaders() const override
+		{
+			for (size_t i = 0; i < InputTableType::Size(); i++)
+			{
+				const SubResourceRevision SubResource = { Input.HandleRevisions[i], Input.SubResourceIndicies[i] };
+				if (const ILazyResourceTable* BlockingTable = FindUnbuiltLazyTable(SubResource))
+				{
+					Builder->AddLazyReader(static_cast<const ILazyRenderPass*>(BlockingTable), this);
+				}
+				else if (const TransientResourceBase* Resource = ResolveLazyRevision(SubResource).Revision.ImaginaryResource)
+				{
+					Builder->AddLazyReader(Resource, this);
+				}
+			}
+		}
+
+	private:
+		const RenderPassBuilder* Builder = nullptr;
+		const char* Name = nullptr;
+		InputTableType Input;
+		BuildFunctionType BuildFunction;
+		mutable std::optional<OutputTableType> Output;
+		mutable bool Started = false;
+	};
+
+	/* an AssignEntry on the output of a lazy renderpass */
+	struct LazyAssignedEntry final : ILazyResourceTable
+	{
+		LazyAssignedEntry(const SubResourceRevision& InSource, U32 InDestinationSubResourceIndex)
+			: Source(InSource)
+			, DestinationSubResourceIndex(InDestinationSubResourceIndex) {}
+
+		const char* GetName() const override
+		{
+			return "RenameAllEntries";
+		}
+
+		SubResourceRevision Resolve(U32) const override
+		{
+			return AssignSubResource(ResolveLazyRevision(Source), DestinationSubResourceIndex);
+		}
+
+		bool IsBuilt() const override
+		{
+			return IsLazyRevisionBuilt(Source);
+		}
+
+		bool CanResolve(U32) const override
+		{
+			return CanResolveLazyRevision(Source);
+		}
+
+		const ILazyResourceTable* GetBlockingTable(U32) const override
+		{
+			return FindUnbuiltLazyTable(Source);
+		}
+
+	private:
+		SubResourceRevision Source;
+		U32 DestinationSubResourceIndex = ALL_SUBRESOURCE_INDICIES;
+	};
+
+	static SubResourceRevision AssignSubResource(SubResourceRevision SubResource, U32 DestinationSubResourceIndex)
+	{
+		U32 NumSubResources = SubResource.Revision.ImaginaryResource->GetNumSubResources();
+		SubResource.SubResourceIndex = (DestinationSubResourceIndex == ALL_SUBRESOURCE_INDICIES) && (NumSubResources == 1) ? 0 : DestinationSubResourceIndex;
+		return SubResource;
+	}
+
+	template<typename OutputTableType, typename InputTableType, typename BuildFunctionType>
+	OutputTableType RecordLazyRenderPass(const char* Name, const InputTableType& Input, const BuildFunctionType& BuildFunction) const
+	{
+		typedef TLazyRenderPass<InputTableType, OutputTableType, BuildFunctionType> LazyRenderPassType;
+		const LazyRenderPassType* LazyPass = new (LinearAlloc<LazyRenderPassType>()) LazyRenderPassType(this, Name, Input, BuildFunction);
+		PendingLazyPasses.push_back(LazyPass);
+		LazyPass->AddToLazyReaders();
+
+		SubResourceRevision LazyOutputs[OutputTableType::Size()];
+		for (SubResourceRevision& LazyOutput : LazyOutputs)
+		{
+			LazyOutput.Revision.Parent = LazyPass;
+		}
+		OutputTableType LazyOutputTable(Name, LazyOutputs);
+		//the index refers to the storage of the table the pass is going to return
+		for (U32 i = 0; i < OutputTableType::Size(); i++)
+		{
+			LazyOutputTable.SubResourceIndicies[i] = i;
+		}
+		return LazyOutputTable;
+	}
+
+	template<typename Handle, typename TableType>
+	static void ResolveLazyEntry(TableType& Table)
+	{
+		constexpr int Index = TableType::CompatibleTypes::template GetIndex<typename Handle::CompatibleType>();
+		const SubResourceRevision SubResource = ResolveLazyRevision({ Table.HandleRevisions[Index], Table.SubResourceIndicies[Index] });
+		Table.HandleRevisions[Index] = SubResource.Revision;
+		Table.SubResourceIndicies[Index] = SubResource.SubResourceIndex;
+	}
+
+	template<typename TableType>
+	void ResolveLazyInputs(TableType& Table) const
+	{
+		for (size_t i = 0; i < TableType::Size(); i++)
+		{
+			const SubResourceRevision SubResource = ResolveLazyRevision({ Table.HandleRevisions[i], Table.SubResourceIndicies[i] });
+			Table.HandleRevisions[i] = SubResource.Revision;
+			Table.SubResourceIndicies[i] = SubResource.SubResourceIndex;
+		}
+
+		//lazy passes that read a resource this action writes have to be recorded before it, as they were when building eagerly
+		//tasks only start once there are no lazy passes left to build
+		if (!LazyReaders.empty() && !IsRecordingTask())
+		{
+			for (size_t i = 0; i < TableType::Size(); i++)
+			{
+				if (TableType::AreOutputResources[i])
+				{
+					BuildLazyPassesReading(Table.HandleRevisions[i].ImaginaryResource);
+				}
+			}
+		}
+	}
+
+	void BuildPendingLazyPasses() const
+	{
+		if (IsRecordingTask())
+		{
+			return;
+		}
+
+		//building a pass can record new lazy passes, so the list is indexed
+		for (size_t i = 0; i < PendingLazyPasses.size(); i++)
+		{
+			const ILazyRenderPass* LazyPass = PendingLazyPasses[i];
+			if (!LazyPass->IsStarted() && LazyPass->CanBuild())
+			{
+				LazyPass->Build();
+			}
+		}
+	}
+
+	bool IsRecordingTask() const
+	{
+		return CurrentTaskRecording && CurrentTaskRecording->Builder == this;
+	}
+
+	/* the lists are linked by index, so they stay valid while building a pass appends to them */
+	void AddLazyReader(U32& ListIndex, const void* Input, const ILazyRenderPass* LazyPass) const
+	{
+		if (ListIndex >= LazyReaderLists.size() || LazyReaderLists[ListIndex].Input != Input)
+		{
+			ListIndex = U32(LazyReaderLists.size());
+			LazyReaderLists.push_back({ Input, ~0u, ~0u });
+		}
+
+		const U32 Index = U32(LazyReaders.size());
+		LazyReaders.push_back({ LazyPass, ~0u });
+		LazyReaderList& List = LazyReaderLists[ListIndex];
+		if (List.First == ~0u)
+		{
+			List.First = Index;
+		}
+		else
+		{
+			LazyReaders[List.Last].Next = Index;
+		}
+		List.Last = Index;
+	}
+
+	void AddLazyReader(const TransientResourceBase* Resource, const ILazyRenderPass* LazyPass) const
+	{
+		AddLazyReader(Resource->LazyReaderList, Resource, LazyPass);
+	}
+
+	/* the blocking table is always a lazy renderpass, assigned entries report the pass they wait for */
+	void AddLazyReader(const ILazyRenderPass* BlockingPass, const ILazyRenderPass* LazyPass) const
+	{
+		AddLazyReader(BlockingPass->LazyReaderList, BlockingPass, LazyPass);
+	}
+
+	/* the passes that waited for this one know the resources of those inputs now */
+	void OnLazyPassBuilt(const ILazyRenderPass* LazyPass) const
+	{
+		if (LazyPass->LazyReaderList >= LazyReaderLists.size())
+			return;
+
+		const U32 First = LazyReaderLists[LazyPass->LazyReaderList].First;
+		LazyReaderLists[LazyPass->LazyReaderList].First = ~0u;
+		for (U32 i = First; i != ~0u; i = LazyReaders[i].Next)
+		{
+			if (!LazyReaders[i].Pass->IsStarted())
+			{
+				LazyReaders[i].Pass->AddToLazyReaders();
+			}
+		}
+	}
+
+	void BuildLazyPassesReading(const TransientResourceBase* Resource) const
+	{
+		const U32 ListIndex = Resource ? Resource->LazyReaderList : ~0u;
+		if (ListIndex >= LazyReaderLists.size() || LazyReaderLists[ListIndex].Input != Resource)
+			return;
+
+		//started passes are unlinked so later writes of the resource do not look at them again
+		//only the outermost scan unlinks, a scan of the same list from a pass it builds just reads it
+		LazyPassScanDepth++;
+		U32 Previous = ~0u;
+		U32 Current = LazyReaderLists[ListIndex].First;
+		while (Current != ~0u)
+		{
+			const ILazyRenderPass* LazyPass = LazyReaders[Current].Pass;
+			if (!LazyPass->IsStarted() && LazyPass->CanBuild())
+			{
+				LazyPass->Build();
+			}
+
+			//read after the build, it might have appended to the list
+			const U32 Next = LazyReaders[Current].Next;
+			if (LazyPass->IsStarted() && LazyPassScanDepth == 1)
+			{
+				LazyReaderList& List = LazyReaderLists[ListIndex];
+				if (Previous == ~0u)
+				{
+					List.First = Next;
+				}
+				else
+				{
+					LazyReaders[Previous].Next = Next;
+				}
+				if (List.Last == Current)
+				{
+					List.Last = Previous;
+				}
+			}
+			else
+			{
+				Previous = Current;
+			}
+			Current = Next;
+		}
+		LazyPassScanDepth--;
+	}
+
+	static U64 HashInputs(const IRenderPassAction* Action)
+	{
+		U64 Hash = U64(UintPtr(Action->GetTaskType()));
+		for (const ResourceTableEntry& Entry : Action->GetRenderPassData())
+		{
+			Hash = Hash * 1610612741 + U64(UintPtr(Entry.GetName()));
+			Hash = Hash * 1610612741 + Entry.GetSubResourceIndex();
+			if (!Entry.IsUndefined())
+			{
+				Hash = Hash * 1610612741 + U64(UintPtr(Entry.GetImaginaryResource()));
+				Hash = Hash * 1610612741 + U64(UintPtr(Entry.GetParent()));
+			}
+			else if (Entry.GetImaginaryResource())
+			{
+				Hash = Hash * 1610612741 + Entry.GetImaginaryResource()->GetResourceByteSize();
+			}
+		}
+		return Hash;
+	}
+
+	/* defined entries have to be the same revision, new resources only need an equivalent descriptor */
+	/* the same task type and name mean the same action type, so entries at the same position were created by the same handle */
+	static bool IsEquivalentAction(const IRenderPassAction* Action, const IRenderPassAction* Other)
+	{
+		if (Action->GetTaskType() != Other->GetTaskType() || strcmp(Action->GetName(), Other->GetName()) != 0)
+			return false;
+
+		IResourceTableInfo::Iterator OtherIter = Other->GetRenderPassData().begin();
+		for (const ResourceTableEntry& Entry : Action->GetRenderPassData())
+		{
+			const ResourceTableEntry OtherEntry = *OtherIter;
+			++OtherIter;
+
+			if (Entry.GetSubResourceIndex() != OtherEntry.GetSubResourceIndex() || Entry.IsUndefined() != OtherEntry.IsUndefined())
+				return false;
+
+			const TransientResourceBase* Resource = Entry.GetImaginaryResource();
+			const TransientResourceBase* OtherResource = OtherEntry.GetImaginaryResource();
+			if (!Entry.IsUndefined())
+			{
+				if (Resource != OtherResource || Entry.GetParent() != OtherEntry.GetParent())
+					return false;
+			}
+			else if (Resource != OtherResource && (!Resource || !OtherResource || !Resource->IsEquivalent(*OtherResource)))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/* the outputs of an earlier action can only be reused while it is still the last writer of all of them */
+	bool IsOverwritten(U32 ActionIndex) const
+	{
+		for (const ResourceTableEntry& Output : ActionList[ActionIndex]->GetRenderPassData())
+		{
+			if (!Output.IsOutput())
+				continue;
+
+			auto Iter = LastWriters.find(Output.GetImaginaryResource());
+			if (Iter != LastWriters.end() && Iter->second != ActionIndex)
+				return true;
+		}
+		return false;
+	}
+
+	void RecordAction(IRenderPassAction* Action) const
+	{
+		if (IsRecordingTask())
+		{
+			CurrentTaskRecording->Actions->push_back(Action);
+			return;
+		}
+
+		Action->RecordIndex = U32(ActionList.size());
+		ActionList.push_back(Action);
+
+		if (GraphKeyRecording)
+		{
+			AddGraphKeys(Action);
+		}
+
+		if (!DeduplicateActions)
+			return;
+
+		for (const ResourceTableEntry& Entry : Action->GetRenderPassData())
+		{
+			if (Entry.IsOutput())
+			{
+				LastWriters[Entry.GetImaginaryResource()] = Action->RecordIndex;
+			}
+		}
+	}
+
+	/* the name and number of entries of the action, then the name, flags, producer and resource id of every entry */
+	/* the size of a resource follows its first entry, so the keys describe the graph ActionGraph::Compile builds before culling changed anything */
+	void AddGraphKeys(const IRenderPassAction* Action) const
+	{
+		const size_t FirstKey = GraphKeys.size();
+		//names are static strings, so their address is as stable as the string
+		GraphKeys.push_back(U64(UintPtr(Action->GetName())));
+		GraphKeys.push_back(0);
+		U64 NumEntries = 0;
+		for (const ResourceTableEntry& Entry : Action->GetRenderPassData())
+		{
+			NumEntries++;
+			GraphKeys.push_back(U64(UintPtr(Entry.GetName())));
+			GraphKeys.push_back((Entry.IsOutput() ? 1 : 0) | (Entry.IsUndefined() ? 2 : 0) | (Entry.IsMaterialized() ? 4 : 0));
+			GraphKeys.push_back(Entry.GetSubResourceIndex());
+
+			const IRenderPassAction* Producer = Entry.IsUndefined() ? nullptr : Entry.GetParent()->GetAction();
+			GraphKeys.push_back(Producer ? Producer->GetRecordIndex() : ~0u);
+
+			const TransientResourceBase* Resource = Entry.GetImaginaryResource();
+			if (!Resource)
+			{
+				GraphKeys.push_back(~0u);
+				continue;
+			}
+
+			//the same dense ids ActionGraph::Compile hands out, it keeps the ones assigned here
+			if (Resource->GraphIndex >= GraphKeyResources.size() || GraphKeyResources[Resource->GraphIndex] != Resource)
+			{
+				Resource->GraphIndex = U32(GraphKeyResources.size());
+				GraphKeyResources.push_back(Resource);
+				GraphKeys.push_back(Resource->GraphIndex);
+				GraphKeys.push_back(Resource->GetResourceByteSize());
+				GraphKeys.push_back(Resource->GetNumSubResourceWords());
+			}
+			else
+			{
+				GraphKeys.push_back(Resource->GraphIndex);
+			}
+		}
+		GraphKeys[FirstKey + 1] = NumEntries;
+
+		for (size_t i = FirstKey; i < GraphKeys.size(); i++)
+		{
+			StructuralHash = StructuralHash * 1610612741 + GraphKeys[i];
+		}
+	}
+
+	const IRenderPassAction* FindEquivalentAction(const IRenderPassAction* Action, ERenderActionFlags::Type Flags) const
+	{
+		if (!DeduplicateActions || !Any(Flags, ERenderActionFlags::Deduplicate) || Action->GetTaskType() == nullptr || IsRecordingTask())
+			return nullptr;
+
+		const U64 Hash = HashInputs(Action);
+		auto Range = ActionsByInput.equal_range(Hash);
+		for (auto Iter = Range.first; Iter != Range.second; ++Iter)
+		{
+			if (IsEquivalentAction(ActionList[Iter->second], Action) && !IsOverwritten(Iter->second))
+			{
+				NumDeduplicatedActions++;
+				return ActionList[Iter->second];
+			}
+		}
+
+		ActionsByInput.emplace(Hash, U32(ActionList.size()));
+		return nullptr;
+	}
+
 	struct IsMutableOp
 	{
 		template<typename T>
@@ -185,14 +905,78 @@ private:
 			return RenderPassData;
 		}
 
-		void Execute(ImmediateRenderContext& RndCtx) const override
+		const void* GetTaskType() const override
+		{
+			static const char TaskType = 0;
+			return std::is_empty_v<FunctionType> ? &TaskType : nullptr;
+		}
+
+		bool RequiresImmediateContext() const override
+		{
+			return std::is_same_v<ContextType, ImmediateRenderContext>;
+		}
+
+		template<typename... TS>
+		static constexpr bool CanRunOnAsyncCompute(const ResourceTable<TS...>*)
 		{
-			RenderPassData.OnProcess([&RndCtx](auto Handle, auto Resource, U32 SubresourceIndex) 
+			return (TS::IsOutputResource || ...) && !(TS::RequiresGraphicsQueue || ...);
+		}
+
+		bool CanRunOnAsyncCompute() const override
+		{
+			return CanRunOnAsyncCompute(static_cast<const RenderPassDataType*>(nullptr));
+		}
+
+		void GatherBarriers(std::vector<ResourceBarrier>& OutBarriers) const override
+		{
+			BarrierListContext ListCtx{ OutBarriers };
+			RenderPassData.OnProcess([&ListCtx](auto Handle, const auto& Resource, U32 SubresourceIndex)
 			{
 				using HandleType = decltype(Handle);
-				HandleType::OnExecute(RndCtx, Resource, SubresourceIndex);
+				HandleType::OnExecute(ListCtx, Resource, SubresourceIndex);
 			});
-			Task(checked_cast<ContextType&>(RndCtx), RenderPassData);
+		}
+
+		/* the transitions of all handles go out as one batch, then the handles are bound and the task runs */
+		void CompileCommands(ExecutionPlan& Plan) const override
+		{
+			RenderPassData.OnProcess([&Plan](auto Handle, const auto& Resource, U32 SubresourceIndex)
+			{
+				using HandleType = decltype(Handle);
+				Plan.AddCommand(&GatherHandleBarriers<HandleType>, &Resource, SubresourceIndex);
+			});
+			Plan.AddCommand(&FlushBarriers, this);
+			RenderPassData.OnProcess([&Plan](auto Handle, const auto& Resource, U32 SubresourceIndex)
+			{
+				using HandleType = decltype(Handle);
+				Plan.AddCommand(&BindHandle<HandleType>, &Resource, SubresourceIndex);
+			});
+			Plan.AddCommand(&ExecuteTask, this);
+		}
+
+		template<typename HandleType>
+		static void GatherHandleBarriers(CommandRenderContext& RndCtx, const ExecutionPlan::Command& Cmd)
+		{
+			BarrierGatherContext GatherCtx{ RndCtx };
+			HandleType::OnExecute(GatherCtx, *static_cast<const typename HandleType::ResourceType*>(Cmd.Object), Cmd.SubResourceIndex);
+		}
+
+		static void FlushBarriers(CommandRenderContext& RndCtx, const ExecutionPlan::Command&)
+		{
+			RndCtx.FlushBarriers();
+		}
+
+		template<typename HandleType>
+		static void BindHandle(CommandRenderContext& RndCtx, const ExecutionPlan::Command& Cmd)
+		{
+			BindingContext BindCtx{ RndCtx };
+			HandleType::OnExecute(BindCtx, *static_cast<const typename HandleType::ResourceType*>(Cmd.Object), Cmd.SubResourceIndex);
+		}
+
+		static void ExecuteTask(CommandRenderContext& RndCtx, const ExecutionPlan::Command& Cmd)
+		{
+			const TRenderPassAction* Action = static_cast<const TRenderPassAction*>(Cmd.Object);
+			Action->Task(checked_cast<ContextType&>(RndCtx), Action->RenderPassData);
 		}
 
 		IterableResourceTable<RenderPassDataType> RenderPassData;
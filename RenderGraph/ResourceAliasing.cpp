@@ -0,0 +1,128 @@
+#include "ResourceAliasing.h"
+#include "Plumber.h"
+#include <algorithm>
+#include <unordered_map>
+#include <stdio.h>
+
+static U64 AlignHeapSize(U64 Size)
+{
+	return (Size + ResourceAliasingPlan::HeapAlignment - 1) & ~(ResourceAliasingPlan::HeapAlignment - 1);
+}
+
+void ResourceAliasingPlan::Compile(const std::vector<const IRenderPassAction*>& InAllActions)
+{
+	Resources.clear();
+	AliasedPeak = 0;
+	NaivePeak = 0;
+
+	std::unordered_map<const TransientResourceBase*, size_t> ResourceIndices;
+	U32 ExecutionIndex = 0;
+	for (const IRenderPassAction* Action : InAllActions)
+	{
+		//culled actions are never executed and therefore do not extend any lifetime
+		if (Action->GetColor() == UINT_MAX)
+			continue;
+
+		for (const ResourceTableEntry& Entry : Action->GetRenderPassData())
+		{
+			const TransientResourceBase* Resource = Entry.GetImaginaryResource();
+			if (Resource == nullptr || !Entry.IsMaterialized() || Resource->IsExternalResource())
+				continue;
+
+			auto Iter = ResourceIndices.find(Resource);
+			if (Iter == ResourceIndices.end())
+			{
+				AliasedResource NewResource;
+				NewResource.Resource = Resource;
+				NewResource.Size = AlignHeapSize(Resource->GetResourceByteSize());
+				NewResource.FirstUse = ExecutionIndex;
+				NewResource.LastUse = ExecutionIndex;
+				ResourceIndices[Resource] = Resources.size();
+				Resources.push_back(NewResource);
+			}
+			else
+			{
+				Resources[Iter->second].LastUse = ExecutionIndex;
+			}
+		}
+		ExecutionIndex++;
+	}
+
+	PlaceResources();
+}
+
+/* greedy interval graph placement: big resources first, each goes into the lowest gap that is free for its whole lifetime */
+void ResourceAliasingPlan::PlaceResources()
+{
+	std::vector<size_t> PlacementOrder(Resources.size());
+	for (size_t i = 0; i < PlacementOrder.size(); i++)
+	{
+		PlacementOrder[i] = i;
+	}
+
+	std::stable_sort(PlacementOrder.begin(), PlacementOrder.end(), [this](size_t a, size_t b)
+	{
+		if (Resources[a].Size != Resources[b].Size)
+		{
+			return Resources[a].Size > Resources[b].Size;
+		}
+		return Resources[a].FirstUse < Resources[b].FirstUse;
+	});
+
+	std::vector<const AliasedResource*> Placed;
+	std::vector<const AliasedResource*> Conflicts;
+	for (size_t Index : PlacementOrder)
+	{
+		AliasedResource& Resource = Resources[Index];
+		NaivePeak += Resource.Size;
+
+		Conflicts.clear();
+		for (const AliasedResource* Other : Placed)
+		{
+			if (Resource.Overlaps(*Other))
+			{
+				Conflicts.push_back(Other);
+			}
+		}
+
+		std::sort(Conflicts.begin(), Conflicts.end(), [](const AliasedResource* a, const AliasedResource* b)
+		{
+			return a->HeapOffset < b->HeapOffset;
+		});
+
+		U64 Offset = 0;
+		for (const AliasedResource* Other : Conflicts)
+		{
+			if (Offset + Resource.Size <= Other->HeapOffset)
+				break;
+
+			Offset = std::max(Offset, Other->HeapOffset + Other->Size);
+		}
+
+		Resource.HeapOffset = Offset;
+		AliasedPeak = std::max(AliasedPeak, Offset + Resource.Size);
+		Placed.push_back(&Resource);
+	}
+}
+
+U64 ResourceAliasingPlan::GetHeapOffset(const TransientResourceBase* Resource) const
+{
+	for (const AliasedResource& Entry : Resources)
+	{
+		if (Entry.Resource == Resource)
+		{
+			return Entry.HeapOffset;
+		}
+	}
+	return ~0ull;
+}
+
+void ResourceAliasingPlan::Print() const
+{
+	for (const AliasedResource& Entry : Resources)
+	{
+		printf("AliasedResource: %s Offset: %llukb Size: %llukb Lifetime: [%u, %u] \n", Entry.Resource->GetResourceName(), 
+			(unsigned long long)(Entry.HeapOffset / 1024), (unsigned long long)(Entry.Size / 1024), Entry.FirstUse, Entry.LastUse);
+	}
+	printf("Aliased peak: %llukb Naive peak: %llukb \n", (unsigned long long)(AliasedPeak / 1024), (unsigned long long)(NaivePeak / 1024));
+}
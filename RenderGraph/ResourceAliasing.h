@@ -0,0 +1,59 @@
+#pragma once
+#include "Renderpass.h"
+#include "Types.h"
+#include <vector>
+
+/* the lifetime and the placement of one managed transient resource inside the shared heap */
+struct AliasedResource
+{
+	const TransientResourceBase* Resource = nullptr;
+	U64 Size = 0;
+	U32 FirstUse = 0;
+	U32 LastUse = 0;
+	U64 HeapOffset = 0;
+
+	bool Overlaps(const AliasedResource& Other) const
+	{
+		return FirstUse <= Other.LastUse && Other.FirstUse <= LastUse;
+	}
+};
+
+/* packs transient resources with disjoint lifetimes into the same heap memory */
+/* the lifetimes are taken from the order in which the culled actions are executed */
+struct ResourceAliasingPlan
+{
+	static constexpr U64 HeapAlignment = 64 * 1024;
+
+	/* takes the actions in execution order (e.g. GraphProcessor::BuildSchedule), culled actions are skipped */
+	/* needs to run after the GraphProcessor colored the graph so the culled actions and materialized resources are known */
+	void Compile(const std::vector<const IRenderPassAction*>& InAllActions);
+
+	/* returns ~0ull if the resource is not part of the plan (external or culled) */
+	U64 GetHeapOffset(const TransientResourceBase* Resource) const;
+
+	const std::vector<AliasedResource>& GetResources() const
+	{
+		return Resources;
+	}
+
+	/* the size of the shared heap */
+	U64 GetAliasedPeak() const
+	{
+		return AliasedPeak;
+	}
+
+	/* the memory needed if every resource had its own allocation */
+	U64 GetNaivePeak() const
+	{
+		return NaivePeak;
+	}
+
+	void Print() const;
+
+private:
+	void PlaceResources();
+
+	std::vector<AliasedResource> Resources;
+	U64 AliasedPeak = 0;
+	U64 NaivePeak = 0;
+};
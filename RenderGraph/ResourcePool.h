@@ -0,0 +1,108 @@
+#pragma once
+#include "Types.h"
+#include "Assert.h"
+#include <mutex>
+#include <utility>
+#include <unordered_map>
+#include <vector>
+
+/* keeps materialized resources alive across frames so an identical descriptor gets a recycled resource instead of a new one */
+/* the ResourceType has to provide a static GetPoolHash(Descriptor), IsPoolCompatible(Descriptor, ResourceFlags) and Recycle(Descriptor) */
+template<typename ResourceType>
+class TransientResourcePool
+{
+	using DescriptorType = typename ResourceType::Descriptor;
+
+	struct PooledResource
+	{
+		ResourceType* Resource = nullptr;
+		U64 LastUsedFrame = 0;
+	};
+
+	/* the resources in use this frame are kept at the front, so finding a free one does not scan them */
+	struct Bucket
+	{
+		std::vector<PooledResource> Entries;
+		size_t NumInUse = 0;
+	};
+
+public:
+	/* resources that were not requested for this many frames are released */
+	static constexpr U64 MaxUnusedFrames = 3;
+
+	static TransientResourcePool& Get()
+	{
+		static TransientResourcePool* Pool = new TransientResourcePool();
+		return *Pool;
+	}
+
+	TransientResourcePool(const TransientResourcePool&) = delete;
+
+	/* hand out a free resource with a matching descriptor or create a new one, it stays in use until the end of the frame */
+	ResourceType* Acquire(const DescriptorType& Descriptor, EResourceFlags::Type ResourceFlags)
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		Bucket& PoolBucket = Resources[ResourceType::GetPoolHash(Descriptor)];
+		std::vector<PooledResource>& Entries = PoolBucket.Entries;
+		for (size_t i = PoolBucket.NumInUse; i < Entries.size(); i++)
+		{
+			if (Entries[i].Resource->IsPoolCompatible(Descriptor, ResourceFlags))
+			{
+				std::swap(Entries[i], Entries[PoolBucket.NumInUse]);
+				ResourceType* Resource = Entries[PoolBucket.NumInUse++].Resource;
+				Resource->Recycle(Descriptor);
+				return Resource;
+			}
+		}
+
+		PooledResource NewEntry;
+		NewEntry.Resource = new ResourceType(Descriptor, ResourceFlags);
+		Entries.push_back(NewEntry);
+		std::swap(Entries.back(), Entries[PoolBucket.NumInUse++]);
+		NumResources++;
+		return NewEntry.Resource;
+	}
+
+	/* call once the frame finished executing: returns all resources of the frame to the pool and frees the ones that went unused for too long */
+	void NextFrame()
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		for (auto Iter = Resources.begin(); Iter != Resources.end();)
+		{
+			Bucket& PoolBucket = Iter->second;
+			std::vector<PooledResource>& Entries = PoolBucket.Entries;
+			for (size_t i = 0; i < PoolBucket.NumInUse; i++)
+			{
+				Entries[i].LastUsedFrame = CurrentFrame;
+			}
+			for (size_t i = PoolBucket.NumInUse; i < Entries.size();)
+			{
+				if (CurrentFrame - Entries[i].LastUsedFrame >= MaxUnusedFrames)
+				{
+					delete Entries[i].Resource;
+					Entries[i] = Entries.back();
+					Entries.pop_back();
+					NumResources--;
+					continue;
+				}
+				i++;
+			}
+			PoolBucket.NumInUse = 0;
+			Iter = Entries.empty() ? Resources.erase(Iter) : ++Iter;
+		}
+		CurrentFrame++;
+	}
+
+	U32 GetNumResources() const
+	{
+		return NumResources;
+	}
+
+private:
+	TransientResourcePool() {}
+
+	std::mutex Mutex;
+	std::unordered_map<U64, Bucket> Resources;
+	U64 CurrentFrame = 0;
+	U32 NumResources = 0;
+};
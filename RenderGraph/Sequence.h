@@ -7,10 +7,12 @@
 template<typename...>
 class ResourceTable;
 
+struct IResourceTableBase;
+
 template<typename... TS>
 static inline void CheckIsValidResourceTable(const ResourceTable<TS...>& Table)
 {
-	static_assert(std::is_base_of<struct IResourceTableBase, ResourceTable<TS...>>(), "Table is not a ResorceTable");
+	static_assert(std::is_base_of<IResourceTableBase, ResourceTable<TS...>>(), "Table is not a ResorceTable");
 	Table.CheckAllValid();
 }
 
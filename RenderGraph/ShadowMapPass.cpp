@@ -19,16 +19,20 @@ typename ShadowMapRenderPass::ShadowMapRenderResult ShadowMapRenderPass::Build(c
 	ShadowViewInfo.SceneHeight = ViewInfo.ShadowResolution;
 	ShadowViewInfo.DepthFormat = ViewInfo.ShadowFormat;
 
-	for (U32 i = 0; i < ShadowViewInfo.ShadowCascades; i++)
+	//the cascades do not depend on each other, only the copies into the array slices have to happen in order
+	Builder.BuildParallel(ShadowViewInfo.ShadowCascades, [&](U32)
+	{
+		return Builder.BuildRenderPass("ShadowMap_DepthRenderPass", DepthRenderPass::Build, ShadowViewInfo)(Input);
+	},
+	[&](U32 i, const DepthRenderPass::DepthRenderResult& CascadeDepth)
 	{
 		Output = Seq
 		{
-			Builder.BuildRenderPass("ShadowMap_DepthRenderPass", DepthRenderPass::Build, ShadowViewInfo),
 			Builder.AssignEntry<RDAG::ShadowMapTextureArray, RDAG::CopyDestination>(i),
 			Builder.AssignEntry<RDAG::DepthTexture, RDAG::CopySource>(),
 			Builder.BuildRenderPass("CopyShadowDepthSlice", CopyTexturePass::Build),
 			Builder.AssignEntry<RDAG::CopyDestination, RDAG::ShadowMapTextureArray>()
-		}(Output);
-	}
+		}(Output.Union(CascadeDepth));
+	});
 	return Output;
 }
\ No newline at end of file
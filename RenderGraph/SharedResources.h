@@ -44,8 +44,9 @@ struct SceneViewInfo
 
 	DepthOfFieldSettings DofSettings;
 
-	char* MainTemporalAAKey = nullptr;
-	char* DoFTemporalAAKey = nullptr;
+	/* names of the external history resources, intern them once with InternedStrings::Intern for the fast lookup path */
+	const char* MainTemporalAAKey = nullptr;
+	const char* DoFTemporalAAKey = nullptr;
 };
 
 namespace RDAG
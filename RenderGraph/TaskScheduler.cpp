@@ -0,0 +1,101 @@
+#include "TaskScheduler.h"
+#include <algorithm>
+
+TaskScheduler::TaskScheduler(U32 NumWorkers)
+{
+	Workers.reserve(NumWorkers);
+	for (U32 i = 0; i < NumWorkers; i++)
+	{
+		Workers.emplace_back([this]() { WorkerMain(); });
+	}
+}
+
+TaskScheduler::~TaskScheduler()
+{
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		Stop = true;
+	}
+	WorkAvailable.notify_all();
+	for (std::thread& Worker : Workers)
+	{
+		Worker.join();
+	}
+}
+
+void TaskScheduler::ParallelFor(U32 Count, const std::function<void(U32)>& Function)
+{
+	//nothing to share, stay on this thread
+	if (Workers.empty() || Count <= 1)
+	{
+		for (U32 i = 0; i < Count; i++)
+		{
+			Function(i);
+		}
+		return;
+	}
+
+	Loop NewLoop;
+	NewLoop.Function = &Function;
+	NewLoop.Count = Count;
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		OpenLoops.push_back(&NewLoop);
+	}
+	WorkAvailable.notify_all();
+
+	RunIterations(NewLoop);
+
+	//the loop lives on this stack, so wait until the workers finished the iterations they took
+	std::unique_lock<std::mutex> Lock(Mutex);
+	LoopFinished.wait(Lock, [&NewLoop]() { return NewLoop.NumFinished.load() == NewLoop.Count && NewLoop.NumWorkers == 0; });
+	OpenLoops.erase(std::find(OpenLoops.begin(), OpenLoops.end(), &NewLoop));
+}
+
+void TaskScheduler::WorkerMain()
+{
+	for (;;)
+	{
+		Loop* OpenLoop = nullptr;
+		{
+			std::unique_lock<std::mutex> Lock(Mutex);
+			WorkAvailable.wait(Lock, [this, &OpenLoop]() { return Stop || (OpenLoop = FindOpenLoop()) != nullptr; });
+			if (OpenLoop == nullptr)
+			{
+				return;
+			}
+			//joining under the lock keeps the owner from leaving while this thread still looks at the loop
+			OpenLoop->NumWorkers++;
+		}
+		RunIterations(*OpenLoop);
+
+		std::lock_guard<std::mutex> Lock(Mutex);
+		OpenLoop->NumWorkers--;
+		LoopFinished.notify_all();
+	}
+}
+
+void TaskScheduler::RunIterations(Loop& InLoop)
+{
+	for (U32 Index = InLoop.NextIndex++; Index < InLoop.Count; Index = InLoop.NextIndex++)
+	{
+		(*InLoop.Function)(Index);
+		if (++InLoop.NumFinished == InLoop.Count)
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			LoopFinished.notify_all();
+		}
+	}
+}
+
+TaskScheduler::Loop* TaskScheduler::FindOpenLoop() const
+{
+	for (Loop* OpenLoop : OpenLoops)
+	{
+		if (OpenLoop->NextIndex.load() < OpenLoop->Count)
+		{
+			return OpenLoop;
+		}
+	}
+	return nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+#include "Types.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* a fixed pool of worker threads that runs the iterations of ParallelFor calls */
+/* the calling thread works on its own loop as well, so nested loops from inside a task can not deadlock */
+class TaskScheduler
+{
+public:
+	explicit TaskScheduler(U32 NumWorkers = DefaultNumWorkers());
+	~TaskScheduler();
+
+	TaskScheduler(const TaskScheduler&) = delete;
+	TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+	/* runs Function(i) for every i below Count and returns once all of them finished */
+	void ParallelFor(U32 Count, const std::function<void(U32)>& Function);
+
+	U32 GetNumWorkers() const
+	{
+		return U32(Workers.size());
+	}
+
+	/* on a single core the workers only take turns with the calling thread, splitting work up then just adds the overhead */
+	bool RunsInParallel() const
+	{
+		return !Workers.empty() && GetNumCores() != 1;
+	}
+
+	/* the cores of the machine, 0 if they are unknown, asked once as it reads the system configuration */
+	static U32 GetNumCores()
+	{
+		static const U32 NumCores = std::thread::hardware_concurrency();
+		return NumCores;
+	}
+
+	/* one worker less than there are cores, the calling thread is the last one */
+	static U32 DefaultNumWorkers()
+	{
+		const U32 NumCores = GetNumCores();
+		return NumCores > 1 ? NumCores - 1 : 0;
+	}
+
+private:
+	struct Loop
+	{
+		const std::function<void(U32)>* Function = nullptr;
+		U32 Count = 0;
+		std::atomic<U32> NextIndex{ 0 };
+		std::atomic<U32> NumFinished{ 0 };
+		/* workers that joined the loop, guarded by the mutex */
+		U32 NumWorkers = 0;
+	};
+
+	void WorkerMain();
+	void RunIterations(Loop& InLoop);
+	Loop* FindOpenLoop() const;
+
+	std::vector<std::thread> Workers;
+	/* loops with iterations left, guarded by the mutex */
+	std::vector<Loop*> OpenLoops;
+	std::mutex Mutex;
+	std::condition_variable WorkAvailable;
+	std::condition_variable LoopFinished;
+	bool Stop = false;
+};
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include <stdint.h>
+#include <climits>
 #include <limits>
 #include <cstring>
 #include <type_traits>
@@ -163,6 +164,23 @@ namespace ERenderResourceFormat
 		Type() : SafeEnum(Invalid) {}
 		Type(const Enum& e) : SafeEnum(e) {}
 	};
+
+	/* size of a single texel, structured resources are treated as 4 byte elements */
+	inline U32 GetBytesPerPixel(const Type& Format)
+	{
+		switch (Format.GetEnum())
+		{
+			case ARGB8U:		return 4;
+			case ARGB16F:		return 8;
+			case ARGB16U:		return 8;
+			case RG16F:			return 4;
+			case L8:			return 1;
+			case D16F:			return 2;
+			case D32F:			return 4;
+			case Structured:	return 4;
+			default:			return 0;
+		}
+	}
 };
 
 namespace EResourceFlags
@@ -181,3 +199,19 @@ namespace EResourceFlags
 		Type(const Enum& e) : SafeEnum(e) {}
 	};
 };
+
+namespace ERenderActionFlags
+{
+	enum Enum
+	{
+		None = 0,
+		Deduplicate = 1 << 0,	//an equivalent action recorded later is merged into this one, only for tasks without captures
+		Default = None,
+	};
+
+	struct Type : SafeEnum<Enum, Type>
+	{
+		Type() : SafeEnum(Default) {}
+		Type(const Enum& e) : SafeEnum(e) {}
+	};
+};
@@ -0,0 +1,74 @@
+#pragma once
+#include "Assert.h"
+#include "Types.h"
+#include <atomic>
+#include <memory>
+
+/* a Chase-Lev deque of task indices, the owning worker pushes and pops at the bottom while other workers steal from the top */
+/* the capacity is fixed up front, a queue never holds more tasks than the graph it runs has, so it never has to grow */
+class WorkStealingQueue
+{
+public:
+	void Reset(U32 InCapacity)
+	{
+		if (InCapacity > Capacity)
+		{
+			Items = std::make_unique<std::atomic<U32>[]>(InCapacity);
+			Capacity = InCapacity;
+		}
+		Top.store(0, std::memory_order_relaxed);
+		Bottom.store(0, std::memory_order_relaxed);
+	}
+
+	/* only called by the owner */
+	void Push(U32 Item)
+	{
+		const I64 B = Bottom.load(std::memory_order_relaxed);
+		check(B < I64(Capacity));
+		Items[B].store(Item, std::memory_order_relaxed);
+		Bottom.store(B + 1, std::memory_order_seq_cst);
+	}
+
+	/* only called by the owner, takes the task pushed last as its inputs are most likely still in the cache */
+	bool Pop(U32& OutItem)
+	{
+		const I64 B = Bottom.load(std::memory_order_relaxed) - 1;
+		Bottom.store(B, std::memory_order_seq_cst);
+		I64 T = Top.load(std::memory_order_seq_cst);
+		if (T > B)
+		{
+			Bottom.store(B + 1, std::memory_order_relaxed);
+			return false;
+		}
+
+		OutItem = Items[B].load(std::memory_order_relaxed);
+		if (T == B)
+		{
+			//the last task, a thief might want it too
+			const bool Won = Top.compare_exchange_strong(T, T + 1, std::memory_order_seq_cst);
+			Bottom.store(B + 1, std::memory_order_relaxed);
+			return Won;
+		}
+		return true;
+	}
+
+	/* called by any other worker, takes the oldest task */
+	bool Steal(U32& OutItem)
+	{
+		I64 T = Top.load(std::memory_order_seq_cst);
+		const I64 B = Bottom.load(std::memory_order_seq_cst);
+		if (T >= B)
+		{
+			return false;
+		}
+
+		OutItem = Items[T].load(std::memory_order_relaxed);
+		return Top.compare_exchange_strong(T, T + 1, std::memory_order_seq_cst);
+	}
+
+private:
+	alignas(64) std::atomic<I64> Top{ 0 };
+	alignas(64) std::atomic<I64> Bottom{ 0 };
+	std::unique_ptr<std::atomic<U32>[]> Items;
+	U32 Capacity = 0;
+};
\ No newline at end of file
@@ -0,0 +1,8 @@
+#!/bin/sh
+# builds and runs the graph benchmark on Linux, all arguments are forwarded to the benchmark (see Benchmark/Benchmark.cpp)
+set -e
+cd "$(dirname "$0")"
+CXX=${CXX:-g++}
+mkdir -p _bench
+$CXX -std=c++17 -O2 -pthread -IRenderGraph -o _bench/rdag_bench Benchmark/Benchmark.cpp $(ls RenderGraph/*.cpp | grep -v Main.cpp)
+./_bench/rdag_bench "$@"